@@ -0,0 +1,125 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+constexpr int MIN_MATCH = 4;
+constexpr int HASH_BITS = 12;
+constexpr std::size_t MAX_OFFSET = 1 << 16;
+
+namespace
+{
+	std::uint32_t Read32(const std::uint8_t* data)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	std::uint32_t Hash(std::uint32_t value)
+	{
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	}
+}
+
+bool ReadVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (data == end)
+			return false;
+
+		const std::uint8_t byte = *data++;
+		value |= std::uint64_t(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+std::vector<std::uint8_t> CompressBlock(std::span<const std::uint8_t> input)
+{
+	std::vector<std::uint8_t> output;
+	output.reserve(input.size() / 2 + 16);
+
+	std::array<std::int64_t, 1 << HASH_BITS> last_seen;
+	last_seen.fill(-1);
+
+	const std::uint8_t* data = input.data();
+	const std::size_t size = input.size();
+	std::size_t literal_start = 0;
+	std::size_t i = 0;
+
+	while (i + MIN_MATCH <= size)
+	{
+		const std::uint32_t value = Read32(data + i);
+		const std::uint32_t hash = Hash(value);
+		const std::int64_t candidate = last_seen[hash];
+		last_seen[hash] = std::int64_t(i);
+
+		if (candidate < 0 || i - std::size_t(candidate) > MAX_OFFSET || Read32(data + candidate) != value)
+		{
+			i++;
+			continue;
+		}
+
+		std::size_t length = MIN_MATCH;
+		while (i + length < size && data[candidate + length] == data[i + length])
+			length++;
+
+		WriteVarint(output, i - literal_start);
+		output.insert(output.end(), data + literal_start, data + i);
+		WriteVarint(output, length - MIN_MATCH);
+		WriteVarint(output, i - std::size_t(candidate));
+
+		i += length;
+		literal_start = i;
+	}
+
+	WriteVarint(output, size - literal_start);
+	output.insert(output.end(), data + literal_start, data + size);
+
+	return output;
+}
+
+bool DecompressBlock(std::span<const std::uint8_t> input, std::size_t raw_size, std::vector<std::uint8_t>& output)
+{
+	// raw_size may come from a corrupt file, so only what the input can plausibly expand to is reserved up front
+	output.clear();
+	output.reserve(std::min(raw_size, input.size() * 16));
+
+	const std::uint8_t* data = input.data();
+	const std::uint8_t* end = data + input.size();
+
+	while (data != end)
+	{
+		std::uint64_t literals;
+		if (!ReadVarint(data, end, literals) || literals > std::uint64_t(end - data) || output.size() + literals > raw_size)
+			return false;
+
+		output.insert(output.end(), data, data + literals);
+		data += literals;
+
+		if (data == end)
+			break;
+
+		std::uint64_t length, offset;
+		if (!ReadVarint(data, end, length) || !ReadVarint(data, end, offset))
+			return false;
+
+		length += MIN_MATCH;
+		if (offset == 0 || offset > output.size() || output.size() + length > raw_size)
+			return false;
+
+		// Copied a byte at a time, since a match may overlap the bytes it produces
+		std::size_t from = output.size() - offset;
+		for (std::uint64_t n = 0; n < length; n++)
+		{
+			const std::uint8_t byte = output[from + n];
+			output.push_back(byte);
+		}
+	}
+
+	return output.size() == raw_size;
+}
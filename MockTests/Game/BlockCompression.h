@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// LEB128 variable length integers, shared by the block codec and the session recording format.
+// Appends to any byte vector, whatever its allocator.
+template<typename Bytes>
+void WriteVarint(Bytes& out, std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(std::uint8_t(value) | 0x80);
+		value >>= 7;
+	}
+	out.push_back(std::uint8_t(value));
+}
+bool ReadVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value);
+
+// Byte oriented LZ77. A block is a series of sequences, each a literal run followed by a
+// back reference; the last sequence has literals only. Boards are mostly runs of the same
+// few characters, which this shrinks well at a low cost per byte.
+std::vector<std::uint8_t> CompressBlock(std::span<const std::uint8_t> input);
+// Returns false when the block is malformed or does not expand to raw_size bytes
+bool DecompressBlock(std::span<const std::uint8_t> input, std::size_t raw_size, std::vector<std::uint8_t>& output);
@@ -3,23 +3,94 @@
 #include "GameStatus.h"
 #include "Player.h"
 #include <algorithm>
+#include <cassert>
+#include <execution>
+#include <numeric>
 
-ComplementsManager::ComplementsManager(IWorld* world, IGameStatus* game_status, IPlayer* player)
+ComplementsManager::ComplementsManager(IWorld* world, IGameStatus* game_status, IPlayer* player, std::pmr::memory_resource* resource)
 	:
+	ComplementsManager(world, std::vector<IGameStatus*>{ game_status }, std::vector<IPlayer*>{ player }, resource)
+{
+}
+
+ComplementsManager::ComplementsManager(IWorld* world, std::vector<IGameStatus*> game_statuses, std::vector<IPlayer*> players, std::pmr::memory_resource* resource)
+	:
+	complements(resource),
 	world_(world),
-	game_status_(game_status),
-	player_(player),
+	game_statuses_(game_statuses.begin(), game_statuses.end(), resource),
+	players_(players.begin(), players.end(), resource),
+	occupancy_(resource),
+	occupied_cells_(resource),
+	column_owner_(resource),
+	workers_(resource),
+	partitions_(resource),
+	score_buffers_(resource),
+	merged_events_(resource),
+	score_events_(resource),
+	player_events_(resource),
 	spawn_rate_(2.5f),
 	time_since_last_spawn_(0.0f),
 	rnd_gen_(),
 	complements_dist_(1, 9),
 	location_dist_(1, world_->GetExtent().x - 2)
 {
+	assert(game_statuses_.size() == players_.size());
+
 	std::random_device rd;
 	rnd_gen_.seed(rd());
 }
 
-void ComplementsManager::UpdateComplementsLifetime(float dt)
+void ComplementsManager::BuildOccupancyIndex(Location2D extent)
+{
+	// Clear the previous tick's cells before resizing, they may lie past a smaller extent
+	for (int cell : occupied_cells_)
+		occupancy_[cell] = -1;
+	occupied_cells_.clear();
+	occupancy_.resize(size_t(extent.x) * extent.y, -1);
+	column_owner_.assign(extent.x, -1);
+
+	for (int i = 0; i < int(players_.size()); i++)
+	{
+		const Location2D loc = players_[i]->GetLocation();
+
+		if (loc.x < 0 || loc.x >= extent.x || loc.y < 0 || loc.y >= extent.y)
+			continue;
+
+		// When players share a cell the lowest index catches, keeping results deterministic
+		int cell = loc.y * extent.x + loc.x;
+		if (occupancy_[cell] == -1)
+		{
+			occupancy_[cell] = i;
+			occupied_cells_.push_back(cell);
+		}
+		if (column_owner_[loc.x] == -1)
+			column_owner_[loc.x] = i;
+	}
+
+	// With nobody on the board every miss is still charged, to the first player as with a single one
+	if (occupied_cells_.empty())
+	{
+		if (!players_.empty())
+			column_owner_.assign(extent.x, 0);
+		return;
+	}
+
+	// Columns without a player belong to the nearest one, ties going to the left
+	for (int x = 0, prev = -1; x <= extent.x; x++)
+	{
+		if (x < extent.x && column_owner_[x] == -1)
+			continue;
+
+		for (int gap = prev + 1; gap < x; gap++)
+		{
+			bool to_prev = prev != -1 && (x == extent.x || gap - prev <= x - gap);
+			column_owner_[gap] = to_prev ? column_owner_[prev] : column_owner_[x];
+		}
+		prev = x;
+	}
+}
+
+int ComplementsManager::UpdateComplementsLifetime(float dt)
 {
 	time_since_last_spawn_ += dt;
 
@@ -29,54 +100,160 @@ void ComplementsManager::UpdateComplementsLifetime(float dt)
 		complements.emplace_back(Location2D{ location_dist_(rnd_gen_), 0 }, complements_dist_(rnd_gen_));
 	}
 
-	int points = 0;
+	score_events_.Clear();
+
+	if (worker_count_ > 1)
+		UpdateComplementsParallel(dt);
+	else
+		UpdateComplementsSerial(dt);
+
+	auto new_end = std::remove_if(complements.begin(), complements.end(), [](const Complement& c) { return c.dirty_; });
+	complements.erase(new_end, complements.end());
+
+	DispatchScoreEvents();
+
+	return int(score_events_.GetEvents().size());
+}
+
+void ComplementsManager::UpdateComplementsSerial(float dt)
+{
+	bool tick_prepared = false;
+	Location2D extent{};
 
-	for (auto& complement : complements)
+	for (int i = 0; i < int(complements.size()); i++)
 	{
+		Complement& complement = complements[i];
 		complement.time_since_last_update_ += dt;
+		complement.time_on_board_ += dt;
 
 		if (complement.time_since_last_update_ > complement.update_rate_)
 		{
 			complement.time_since_last_update_ = 0.0f;
 
-			const Location2D extent = world_->GetExtent();
+			if (!tick_prepared)
+			{
+				tick_prepared = true;
+				extent = world_->GetExtent();
+				BuildOccupancyIndex(extent);
+			}
 
-			int prevArrayLocation = complement.loc_.y * extent.x + complement.loc_.x;
+			if (auto event = StepComplement(complement, i, extent))
+				score_events_.Push(*event);
+		}
+	}
+}
 
-			std::string& world_content = world_->GetContentRef();
-			if (world_content[prevArrayLocation] == complement.number_ + char('0'))
-				world_content[prevArrayLocation] = ' ';
+void ComplementsManager::UpdateComplementsParallel(float dt)
+{
+	partitions_.resize(worker_count_);
+	score_buffers_.resize(worker_count_);
+	for (auto& partition : partitions_)
+		partition.clear();
 
-			complement.loc_.y += 1;
+	// Complements of one column always share a partition, so no two workers touch the same cell
+	bool any_step = false;
+	for (int i = 0; i < int(complements.size()); i++)
+	{
+		Complement& complement = complements[i];
+		complement.time_since_last_update_ += dt;
+		complement.time_on_board_ += dt;
 
-			if (complement.loc_ == player_->GetLocation())
+		if (complement.time_since_last_update_ > complement.update_rate_)
+		{
+			complement.time_since_last_update_ = 0.0f;
+			partitions_[complement.loc_.x % worker_count_].push_back(i);
+			any_step = true;
+		}
+	}
+
+	if (any_step)
+	{
+		const Location2D extent = world_->GetExtent();
+		world_->MakeWritable();
+		BuildOccupancyIndex(extent);
+
+		workers_.resize(worker_count_);
+		std::iota(workers_.begin(), workers_.end(), 0);
+
+		std::for_each(std::execution::par, workers_.begin(), workers_.end(), [&](int worker)
 			{
-				complement.dirty_ = true;
+				std::pmr::vector<ScoreEvent>& events = score_buffers_[worker];
+				events.clear();
 
-				if (complement.number_ + player_->GetNumber() == 10)
-				{
-					game_status_->AddToScore(complement.number_);
-				}
-				else
+				for (int i : partitions_[worker])
 				{
-					game_status_->PlayerLifesMinusOne();
+					if (auto event = StepComplement(complements[i], i, extent))
+						events.push_back(*event);
 				}
-				
-			}
-			else if (complement.loc_.y >= extent.y - 1)
-			{
-				complement.dirty_ = true;
-				game_status_->AddToScoreLost(complement.number_);
-			}
-			else
-			{
-				int curArrayLocation = complement.loc_.y * extent.x + complement.loc_.x;
+			});
 
-				world_content[curArrayLocation] = complement.number_ + char('0');
-			}
+		// Replaying in complement order reproduces the serial call sequence exactly
+		merged_events_.clear();
+		for (const auto& events : score_buffers_)
+			merged_events_.insert(merged_events_.end(), events.begin(), events.end());
+		std::sort(merged_events_.begin(), merged_events_.end(), [](const ScoreEvent& lhs, const ScoreEvent& rhs) { return lhs.complement_index_ < rhs.complement_index_; });
+
+		for (const auto& event : merged_events_)
+			score_events_.Push(event);
+	}
+}
+
+std::optional<ScoreEvent> ComplementsManager::StepComplement(Complement& complement, int complement_index, Location2D extent) const
+{
+	int prevArrayLocation = complement.loc_.y * extent.x + complement.loc_.x;
+
+	if (world_->GetCell(prevArrayLocation) == complement.number_ + char('0'))
+		world_->SetCell(prevArrayLocation, ' ');
+
+	complement.loc_.y += 1;
+
+	int curArrayLocation = complement.loc_.y * extent.x + complement.loc_.x;
+	int player_index = complement.loc_.y < extent.y ? occupancy_[curArrayLocation] : -1;
+
+	if (player_index != -1)
+	{
+		complement.dirty_ = true;
+
+		if (complement.number_ + players_[player_index]->GetNumber() == 10)
+		{
+			return ScoreEvent{ complement_index, player_index, ScoreEvent::Type::Score, complement.number_, complement.time_on_board_ };
 		}
+		else
+		{
+			return ScoreEvent{ complement_index, player_index, ScoreEvent::Type::LifeLost, 1, complement.time_on_board_ };
+		}
+	}
+	else if (complement.loc_.y >= extent.y - 1)
+	{
+		complement.dirty_ = true;
+		int owner = column_owner_[complement.loc_.x];
+		if (owner != -1)
+			return ScoreEvent{ complement_index, owner, ScoreEvent::Type::ScoreLost, complement.number_, complement.time_on_board_ };
+	}
+	else
+	{
+		world_->SetCell(curArrayLocation, complement.number_ + char('0'));
 	}
 
-	auto new_end = std::remove_if(complements.begin(), complements.end(), [](const Complement& c) { return c.dirty_; });
-	complements.erase(new_end, complements.end());
+	return std::nullopt;
+}
+
+void ComplementsManager::DispatchScoreEvents()
+{
+	if (score_events_.IsEmpty())
+		return;
+
+	// Group the tick by player, keeping complement order within each group
+	std::span<const ScoreEvent> events = score_events_.GetEvents();
+	player_events_.assign(events.begin(), events.end());
+	std::stable_sort(player_events_.begin(), player_events_.end(), [](const ScoreEvent& lhs, const ScoreEvent& rhs) { return lhs.player_index_ < rhs.player_index_; });
+
+	for (auto first = player_events_.begin(); first != player_events_.end();)
+	{
+		auto last = std::find_if(first, player_events_.end(), [first](const ScoreEvent& e) { return e.player_index_ != first->player_index_; });
+		game_statuses_[first->player_index_]->ApplyEvents(std::span<const ScoreEvent>(first, last));
+		first = last;
+	}
+
+	score_events_.Publish();
 }
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Location2D.h"
+#include "ScoreEvents.h"
 #include <vector>
+#include <memory_resource>
 #include <random>
+#include <string>
+#include <optional>
+#include <algorithm>
 
 class IWorld;
 class IGameStatus;
@@ -11,15 +16,30 @@ class IPlayer;
 class IComplementsManager
 {
 public:
-	virtual void UpdateComplementsLifetime(float dt) = 0;
+	// Returns how many score events the update produced
+	virtual int UpdateComplementsLifetime(float dt) = 0;
+	// Listeners get each tick's events in one call, in complement order
+	virtual void AddEventListener(ScoreEventBuffer::Listener listener) = 0;
 };
 
 class ComplementsManager : public IComplementsManager
 {
 public:
-	ComplementsManager(IWorld* world, IGameStatus* game_status, IPlayer* player);
+	// Complements, the collision index and every per-tick buffer are allocated from the given resource
+	ComplementsManager(IWorld* world, IGameStatus* game_status, IPlayer* player, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	// Each player scores into the game status with the same index.
+	ComplementsManager(IWorld* world, std::vector<IGameStatus*> game_statuses, std::vector<IPlayer*> players, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-	void UpdateComplementsLifetime(float dt) override;
+	int UpdateComplementsLifetime(float dt) override;
+	void AddEventListener(ScoreEventBuffer::Listener listener) override
+	{
+		score_events_.Subscribe(std::move(listener));
+	}
+	// Values above one split the complements into that many column partitions updated in parallel
+	void SetWorkerCount(int worker_count)
+	{
+		worker_count_ = std::max(worker_count, 1);
+	}
 
 public:
 	struct Complement
@@ -29,14 +49,37 @@ public:
 		constexpr static float update_rate_ = 0.5f;
 		float time_since_last_update_;
 		bool dirty_ = false;
+		float time_on_board_ = 0.0f;
 	};
 
-	std::vector<Complement> complements;
+	std::pmr::vector<Complement> complements;
+
+private:
+	void UpdateComplementsSerial(float dt);
+	void UpdateComplementsParallel(float dt);
+	// Moves the complement one row down, returning the score change it caused, if any
+	std::optional<ScoreEvent> StepComplement(Complement& complement, int complement_index, Location2D extent) const;
+	// Hands every game status its own events as one batch, then publishes the tick to listeners
+	void DispatchScoreEvents();
+	// Maps every board cell to the index of the player standing on it (or -1) and
+	// every column to the player charged for its misses, so each complement step
+	// resolves with a single lookup.
+	void BuildOccupancyIndex(Location2D extent);
 
 private:
 	IWorld* world_;
-	IGameStatus* game_status_;
-	IPlayer* player_;
+	std::pmr::vector<IGameStatus*> game_statuses_;
+	std::pmr::vector<IPlayer*> players_;
+	std::pmr::vector<int> occupancy_;
+	std::pmr::vector<int> occupied_cells_;
+	std::pmr::vector<int> column_owner_;
+	int worker_count_ = 1;
+	std::pmr::vector<int> workers_;
+	std::pmr::vector<std::pmr::vector<int>> partitions_;
+	std::pmr::vector<std::pmr::vector<ScoreEvent>> score_buffers_;
+	std::pmr::vector<ScoreEvent> merged_events_;
+	ScoreEventBuffer score_events_;
+	std::pmr::vector<ScoreEvent> player_events_;
 	float spawn_rate_;
 	float time_since_last_spawn_;
 
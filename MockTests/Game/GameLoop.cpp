@@ -3,37 +3,99 @@
 #include "Player.h"
 #include "ComplementsManager.h"
 #include "GameStatus.h"
+#include "SessionRecording.h"
 #include "WinInclude.h"
-#include "Timer.h"
 #include <iostream>
 #include <chrono>
-#include <thread>
+#include <optional>
 
 constexpr bool IS_TEST = true;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+// How often a screen waiting for a key checks the keyboard
+constexpr float KEY_POLL_TIME = 1.0f / 20.0f;
 
 GameLoop::GameLoop()
 	:
-	world_(std::make_unique<World>(Location2D{ 17, 17 })),
-	game_status_(std::make_unique<GameStatus>()),
-	player_(std::make_unique<Player>(Location2D{ 8, 15 }, world_.get())),
-	comps_manager_(std::make_unique<ComplementsManager>(world_.get(), game_status_.get(), player_.get()))
+	GameLoop(std::pmr::get_default_resource())
 {
 }
 
+GameLoop::GameLoop(std::pmr::memory_resource* resource)
+	:
+	resource_(resource),
+	world_(std::allocate_shared<World>(std::pmr::polymorphic_allocator<World>(resource), Location2D{ 17, 17 }, resource)),
+	game_status_(std::allocate_shared<GameStatus>(std::pmr::polymorphic_allocator<GameStatus>(resource))),
+	player_(std::allocate_shared<Player>(std::pmr::polymorphic_allocator<Player>(resource), Location2D{ 8, 15 }, world_.get())),
+	comps_manager_(std::allocate_shared<ComplementsManager>(std::pmr::polymorphic_allocator<ComplementsManager>(resource), world_.get(), game_status_.get(), player_.get(), resource)),
+	telemetry_(1, resource),
+	telemetry_path_(resource),
+	recording_path_(resource)
+{
+	ListenToScoreEvents();
+}
+
 GameLoop::GameLoop(std::shared_ptr<IWorld> world, std::shared_ptr<IGameStatus> game_status, std::shared_ptr<IPlayer> player, std::shared_ptr<IComplementsManager> comps_manager)
 	:
+	resource_(std::pmr::get_default_resource()),
 	world_(world),
 	game_status_(game_status),
 	player_(player),
 	comps_manager_(comps_manager)
 {
+	ListenToScoreEvents();
 }
 
 GameLoop::~GameLoop()
 {
 }
 
+void GameLoop::ListenToScoreEvents()
+{
+	comps_manager_->AddEventListener(
+		[this](std::span<const ScoreEvent> events)
+		{
+			telemetry_.RecordScoreEvents(events);
+			if (recorder_)
+				recorder_->AddEvents(events);
+		});
+}
+
+bool GameLoop::IsKeyDown(int key)
+{
+	return (GetAsyncKeyState(key) & 0x8000) != 0;
+}
+
 void GameLoop::Start()
+{
+	Scheduler scheduler;
+	scheduler.Spawn(Session(scheduler));
+	scheduler.Run();
+}
+
+void GameLoop::Run()
+{
+	Scheduler scheduler;
+	scheduler.Spawn(Play(scheduler));
+	scheduler.Run();
+}
+
+void GameLoop::SetTelemetryExport(std::string_view path, float interval)
+{
+	telemetry_path_ = path;
+	telemetry_interval_ = interval;
+}
+
+void GameLoop::SetRecording(std::string_view path)
+{
+	recording_path_ = path;
+}
+
+void GameLoop::SetKeyState(KeyState key_state)
+{
+	key_state_ = std::move(key_state);
+}
+
+Task GameLoop::Session(Scheduler& scheduler)
 {
 	if constexpr(!IS_TEST)
 	{
@@ -46,12 +108,12 @@ void GameLoop::Start()
 		std::cout << "    DOWN - Decrease number\n\n";
 		std::cout << "    Press enter to start\n";
 
-		while (!(GetAsyncKeyState(VK_RETURN) & 0x8000));
+		co_await scheduler.WaitUntil([this]() { return key_state_(VK_RETURN); }, KEY_POLL_TIME);
 
 		std::system("cls");
 	}
 
-	Run();
+	co_await Play(scheduler);
 
 	if constexpr (!IS_TEST)
 	{
@@ -63,50 +125,94 @@ void GameLoop::Start()
 	{
 		std::cout << "\n\n    Press enter to close\n";
 
-		while (!(GetAsyncKeyState(VK_RETURN) & 0x8000));
+		co_await scheduler.WaitUntil([this]() { return key_state_(VK_RETURN); }, KEY_POLL_TIME);
 	}
 }
 
-void GameLoop::Run()
+Task GameLoop::Play(Scheduler& scheduler)
 {
 	player_->UpdateWorldLocation({ 0, 0 });
 
-	Timer timer{};
+	if (!recording_path_.empty())
+		recorder_ = std::allocate_shared<SessionRecorder>(std::pmr::polymorphic_allocator<SessionRecorder>(resource_),
+			recording_path_, *world_, *game_status_, SessionRecorder::DEFAULT_TICKS_PER_CHUNK, RecordingWriter::GetShared(), resource_);
+
+	double last_frame_time = scheduler.GetTime();
+	double next_export_time = scheduler.GetTime() + telemetry_interval_;
+	// Set when a frame's input changed the player, until the frame showing it is drawn
+	std::optional<std::chrono::steady_clock::time_point> input_sample_time;
 
-	while (!game_status_->IsGameOver())
+	bool game_over = game_status_->IsGameOver();
+
+	while (!game_over)
 	{
 		world_->Draw();
 		game_status_->Draw();
+		// The frame only reaches the console once flushed, which is where the latency ends
+		std::cout.flush();
+		if (input_sample_time)
+		{
+			telemetry_.RecordInputLatency(std::chrono::steady_clock::now() - *input_sample_time);
+			input_sample_time.reset();
+		}
+
+		if (!telemetry_path_.empty() && scheduler.GetTime() >= next_export_time)
+		{
+			RecordingWriter::GetShared().AppendToFile(std::string(telemetry_path_), telemetry_.Summary(scheduler.GetTime()));
+			next_export_time = scheduler.GetTime() + telemetry_interval_;
+		}
 
 		Location2D displacement = { 0, 0 };
-		int player_number = player_->GetNumber();
+		const auto sample_time = std::chrono::steady_clock::now();
+		const int sampled_number = player_->GetNumber();
+		int player_number = sampled_number;
 
-		if (GetAsyncKeyState('A') & 0x8000) {
+		if (key_state_('A')) {
 			displacement.x = -1;
 		}
-		else if (GetAsyncKeyState('D') & 0x8000) {
+		else if (key_state_('D')) {
 			displacement.x = 1;
 		}
 
-		if (GetAsyncKeyState(VK_UP) & 0x8000) {
+		if (key_state_(VK_UP)) {
 			if(++player_number > 9) player_number = 1;
 		}
-		else if (GetAsyncKeyState(VK_DOWN) & 0x8000) {
+		else if (key_state_(VK_DOWN)) {
 			if (--player_number < 1) player_number = 9;
 		}
 
-		if (GetAsyncKeyState(VK_ESCAPE) & 0x8000) {
-			return;
+		if (key_state_(VK_ESCAPE)) {
+			break;
 		}
 
+		if (displacement != Location2D{ 0, 0 } || player_number != sampled_number)
+			input_sample_time = sample_time;
+
 		player_->SetNumber(player_number);
 		player_->UpdateWorldLocation(displacement);
-		comps_manager_->UpdateComplementsLifetime(timer.Tick());
 
-		using namespace std::chrono_literals;
-		std::this_thread::sleep_for(16.667ms);
+		const float dt = float(scheduler.GetTime() - last_frame_time);
+		last_frame_time = scheduler.GetTime();
+
+		// The status only changes through score events, so game over is re-checked just when some happened
+		if (comps_manager_->UpdateComplementsLifetime(dt) > 0)
+			game_over = game_status_->IsGameOver();
+
+		if (recorder_)
+			recorder_->RecordTick();
+
+		co_await scheduler.Delay(FRAME_TIME);
 
 		if constexpr(!IS_TEST)
 			std::system("cls");
 	}
+
+	if (!telemetry_path_.empty())
+		RecordingWriter::GetShared().AppendToFile(std::string(telemetry_path_), telemetry_.Summary(scheduler.GetTime()));
+
+	if (recorder_)
+	{
+		recorder_->Close();
+		recorder_.reset();
+	}
 }
@@ -1,25 +1,67 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "Scheduler.h"
+#include "Telemetry.h"
 
 class IWorld;
 class IGameStatus;
 class IPlayer;
 class IComplementsManager;
+class SessionRecorder;
 
 class GameLoop
 {
 public:
 	GameLoop();
+	// Builds the default session with every object and control block allocated from the resource
+	explicit GameLoop(std::pmr::memory_resource* resource);
 	GameLoop(std::shared_ptr<IWorld> world, std::shared_ptr<IGameStatus> game_status, std::shared_ptr<IPlayer> player, std::shared_ptr<IComplementsManager> comps_manager);
+	GameLoop(const GameLoop&) = delete;
+	GameLoop& operator=(const GameLoop&) = delete;
 	~GameLoop();
 
+	// Tells whether a key is held; defaults to the keyboard
+	using KeyState = std::function<bool(int key)>;
+
 	void Start();
 	void Run();
 
+	// Title screen, play and game over as one coroutine, so many sessions can share a scheduler
+	Task Session(Scheduler& scheduler);
+	Task Play(Scheduler& scheduler);
+
+	// Appends a telemetry summary to the file every interval of session time and when play ends,
+	// through the recording writer's I/O thread so play never waits on the file
+	void SetTelemetryExport(std::string_view path, float interval);
+	// Records every tick of the next play to the file
+	void SetRecording(std::string_view path);
+	void SetKeyState(KeyState key_state);
+	const Telemetry& GetTelemetry() const
+	{
+		return telemetry_;
+	}
+
+private:
+	static bool IsKeyDown(int key);
+	// Feeds every tick's score events to the telemetry and the recording
+	void ListenToScoreEvents();
+
 private:
+	// Where the session's own objects go, the recorder included
+	std::pmr::memory_resource* resource_;
 	std::shared_ptr<IWorld> world_;
 	std::shared_ptr<IGameStatus> game_status_;
 	std::shared_ptr<IPlayer> player_;
 	std::shared_ptr<IComplementsManager> comps_manager_;
+	Telemetry telemetry_;
+	std::pmr::string telemetry_path_;
+	float telemetry_interval_ = 0.0f;
+	std::pmr::string recording_path_;
+	std::shared_ptr<SessionRecorder> recorder_;
+	KeyState key_state_ = &GameLoop::IsKeyDown;
 };
\ No newline at end of file
@@ -2,6 +2,34 @@
 #include <iostream>
 #include <format>
 
+void IGameStatus::ApplyEvents(std::span<const ScoreEvent> events)
+{
+	for (const auto& event : events)
+	{
+		switch (event.type_)
+		{
+		case ScoreEvent::Type::Score:
+			AddToScore(event.value_);
+			break;
+		case ScoreEvent::Type::ScoreLost:
+			AddToScoreLost(event.value_);
+			break;
+		case ScoreEvent::Type::LifeLost:
+			PlayerLifesMinusOne();
+			break;
+		}
+	}
+}
+
+GameStatus::GameStatus(int score, int score_lost, int player_lifes)
+	:
+	score_(score),
+	score_lost_(score_lost),
+	player_lifes_(player_lifes)
+{
+	UpdateGameOver();
+}
+
 void GameStatus::Draw() const
 {
 	std::cout << std::format("\n    SCORE: {}\n", score_);
@@ -12,19 +40,48 @@ void GameStatus::Draw() const
 void GameStatus::AddToScore(int value)
 {
 	score_ += value;
+	UpdateGameOver();
 }
 
 void GameStatus::AddToScoreLost(int value)
 {
 	score_lost_ += value;
+	UpdateGameOver();
 }
 
 void GameStatus::PlayerLifesMinusOne()
 {
 	player_lifes_--;
+	UpdateGameOver();
 }
 
 bool GameStatus::IsGameOver()
 {
-	return player_lifes_ < 0 || score_ < score_lost_;
+	return game_over_;
+}
+
+void GameStatus::ApplyEvents(std::span<const ScoreEvent> events)
+{
+	for (const auto& event : events)
+	{
+		switch (event.type_)
+		{
+		case ScoreEvent::Type::Score:
+			score_ += event.value_;
+			break;
+		case ScoreEvent::Type::ScoreLost:
+			score_lost_ += event.value_;
+			break;
+		case ScoreEvent::Type::LifeLost:
+			player_lifes_--;
+			break;
+		}
+	}
+
+	UpdateGameOver();
+}
+
+void GameStatus::UpdateGameOver()
+{
+	game_over_ = player_lifes_ < 0 || score_ < score_lost_;
 }
@@ -1,5 +1,16 @@
 #pragma once
 
+#include "ScoreEvents.h"
+#include <span>
+
+// Score, score lost and lifes of one player at some point of the game
+struct StatusSnapshot
+{
+	int score_;
+	int score_lost_;
+	int player_lifes_;
+};
+
 class IGameStatus
 {
 public:
@@ -8,20 +19,46 @@ public:
 	virtual void AddToScoreLost(int value) = 0;
 	virtual void PlayerLifesMinusOne() = 0;
 	virtual bool IsGameOver() = 0;
+	virtual StatusSnapshot GetSnapshot() const = 0;
+	// Applies a whole tick of events; the default forwards each one to the calls above
+	virtual void ApplyEvents(std::span<const ScoreEvent> events);
 };
 
 class GameStatus : public IGameStatus
 {
 public:
 	GameStatus() = default;
+	GameStatus(int score, int score_lost, int player_lifes);
 
 	void Draw() const override;
 	void AddToScore(int value) override;
 	void AddToScoreLost(int value) override;
 	void PlayerLifesMinusOne() override;
 	bool IsGameOver() override;
+	StatusSnapshot GetSnapshot() const override
+	{
+		return StatusSnapshot{ score_, score_lost_, player_lifes_ };
+	}
+	void ApplyEvents(std::span<const ScoreEvent> events) override;
+
+	int GetScore() const
+	{
+		return score_;
+	}
+	int GetScoreLost() const
+	{
+		return score_lost_;
+	}
+	int GetPlayerLifes() const
+	{
+		return player_lifes_;
+	}
+private:
+	void UpdateGameOver();
+
 private:
 	int score_ = 0;
 	int score_lost_ = 0;
 	int player_lifes_ = 3;
+	bool game_over_ = false;
 };
\ No newline at end of file
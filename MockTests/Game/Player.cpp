@@ -16,13 +16,12 @@ void Player::UpdateWorldLocation(Location2D displacement)
 
 	int prevArrayLocation = loc_.y * extent.x + loc_.x;
 
-	std::string& world_content = world_->GetContentRef();
-	world_content[prevArrayLocation] = ' ';
+	world_->SetCell(prevArrayLocation, ' ');
 
 	loc_.x = std::clamp(loc_.x + displacement.x, 1, extent.x - 2);
 	loc_.y = std::clamp(loc_.y + displacement.y, 1, extent.y - 2);
 
 	int curArrayLocation = loc_.y * extent.x + loc_.x;
 
-	world_content[curArrayLocation] = number_ + char('0');
+	world_->SetCell(curArrayLocation, number_ + char('0'));
 }
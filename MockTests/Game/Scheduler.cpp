@@ -0,0 +1,161 @@
+#include "Scheduler.h"
+#include "Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+// Every frame starts with the resource it came from, so it is freed there wherever it is destroyed
+constexpr std::size_t FRAME_HEADER_SIZE = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* Task::promise_type::AllocateFrame(std::size_t size, std::pmr::memory_resource* resource)
+{
+	auto* block = static_cast<std::byte*>(resource->allocate(FRAME_HEADER_SIZE + size, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+	*reinterpret_cast<std::pmr::memory_resource**>(block) = resource;
+	return block + FRAME_HEADER_SIZE;
+}
+
+void Task::promise_type::operator delete(void* frame, std::size_t size)
+{
+	auto* block = static_cast<std::byte*>(frame) - FRAME_HEADER_SIZE;
+	std::pmr::memory_resource* resource = *reinterpret_cast<std::pmr::memory_resource**>(block);
+	resource->deallocate(block, FRAME_HEADER_SIZE + size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+std::coroutine_handle<> Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+	promise_type& promise = handle.promise();
+
+	if (promise.continuation_)
+		return promise.continuation_;
+
+	if (promise.scheduler_)
+		promise.scheduler_->OnTaskFinished(handle);
+
+	return std::noop_coroutine();
+}
+
+Task::Task(std::coroutine_handle<promise_type> handle)
+	:
+	handle_(handle)
+{
+}
+
+Task::Task(Task&& other) noexcept
+	:
+	handle_(std::exchange(other.handle_, nullptr))
+{
+}
+
+Task& Task::operator=(Task&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (handle_)
+			handle_.destroy();
+		handle_ = std::exchange(other.handle_, nullptr);
+	}
+	return *this;
+}
+
+Task::~Task()
+{
+	if (handle_)
+		handle_.destroy();
+}
+
+std::coroutine_handle<> Task::await_suspend(std::coroutine_handle<> continuation) noexcept
+{
+	handle_.promise().continuation_ = continuation;
+	return handle_;
+}
+
+std::coroutine_handle<Task::promise_type> Task::Release()
+{
+	return std::exchange(handle_, nullptr);
+}
+
+Scheduler::~Scheduler()
+{
+	for (auto handle : tasks_)
+		handle.destroy();
+}
+
+void Scheduler::Spawn(Task task)
+{
+	std::coroutine_handle<Task::promise_type> handle = task.Release();
+	handle.promise().scheduler_ = this;
+
+	tasks_.push_back(handle);
+	next_frame_.push_back(handle);
+}
+
+void Scheduler::Tick(float dt)
+{
+	now_ += dt;
+
+	resuming_.clear();
+	std::swap(resuming_, next_frame_);
+
+	while (!timers_.empty() && timers_.top().wake_time_ <= now_)
+	{
+		SleepingTask task = timers_.top();
+		timers_.pop();
+
+		if (task.condition_ && !task.condition_())
+			polled_.push_back(std::move(task));
+		else
+			resuming_.push_back(task.handle_);
+	}
+
+	// Polls that failed are re-armed after the loop, so a zero interval cannot spin within one tick
+	for (auto& task : polled_)
+		AddTimer(task.poll_interval_, task.handle_, std::move(task.condition_));
+	polled_.clear();
+
+	for (auto handle : resuming_)
+		handle.resume();
+
+	for (auto handle : finished_)
+	{
+		tasks_.erase(std::find(tasks_.begin(), tasks_.end(), handle));
+		handle.destroy();
+	}
+	finished_.clear();
+}
+
+void Scheduler::Run()
+{
+	Timer timer{};
+
+	while (HasTasks())
+	{
+		Tick(timer.Tick());
+
+		if (HasTasks())
+			std::this_thread::sleep_for(std::chrono::duration<double>(TimeUntilNextWake()));
+	}
+}
+
+void Scheduler::AddTimer(float seconds, std::coroutine_handle<> handle, std::function<bool()> condition)
+{
+	timers_.push(SleepingTask{ now_ + seconds, timer_sequence_++, handle, std::move(condition), seconds });
+}
+
+void Scheduler::OnTaskFinished(std::coroutine_handle<Task::promise_type> handle)
+{
+	finished_.push_back(handle);
+}
+
+double Scheduler::TimeUntilNextWake() const
+{
+	if (!next_frame_.empty())
+		return 0.0;
+
+	double wait = 1.0;
+
+	if (!timers_.empty())
+		wait = std::min(wait, timers_.top().wake_time_ - now_);
+
+	return std::max(wait, 0.0);
+}
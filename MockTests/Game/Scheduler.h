@@ -0,0 +1,197 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <queue>
+#include <type_traits>
+#include <vector>
+#include <exception>
+
+class Scheduler;
+
+// Lazily started coroutine. Either spawned on a Scheduler, which then owns it,
+// or co_awaited from another Task, which resumes when it finishes.
+// The frame of a coroutine taking a Scheduler is allocated from that scheduler's frame resource.
+class Task
+{
+public:
+	struct promise_type
+	{
+		template<typename... Args>
+		static void* operator new(std::size_t size, const Args&... args)
+		{
+			return AllocateFrame(size, FindFrameResource(args...));
+		}
+		static void operator delete(void* frame, std::size_t size);
+
+		static void* AllocateFrame(std::size_t size, std::pmr::memory_resource* resource);
+		static std::pmr::memory_resource* FindFrameResource()
+		{
+			return std::pmr::get_default_resource();
+		}
+		template<typename First, typename... Rest>
+		static std::pmr::memory_resource* FindFrameResource(const First& first, const Rest&... rest)
+		{
+			if constexpr (std::is_same_v<First, Scheduler>)
+				return first.GetFrameResource();
+			else
+				return FindFrameResource(rest...);
+		}
+
+		// Hands control back to the awaiting task, or reports a spawned task as finished
+		struct FinalAwaiter
+		{
+			bool await_ready() noexcept { return false; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+			void await_resume() noexcept {}
+		};
+
+		Task get_return_object()
+		{
+			return Task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+		}
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+		FinalAwaiter final_suspend() noexcept
+		{
+			return {};
+		}
+		void return_void() {}
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+
+		std::coroutine_handle<> continuation_;
+		Scheduler* scheduler_ = nullptr;
+	};
+
+	Task(Task&& other) noexcept;
+	Task& operator=(Task&& other) noexcept;
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task();
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept;
+	void await_resume() const noexcept {}
+
+	std::coroutine_handle<promise_type> Release();
+private:
+	explicit Task(std::coroutine_handle<promise_type> handle);
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+};
+
+// Single threaded cooperative scheduler. Suspended coroutines cost nothing until
+// their frame, timeout or condition comes up, so many sessions can share one thread.
+class Scheduler
+{
+public:
+	explicit Scheduler(std::pmr::memory_resource* frame_resource = std::pmr::get_default_resource())
+		:
+		frame_resource_(frame_resource)
+	{
+	}
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+	~Scheduler();
+
+	void Spawn(Task task);
+	// Advances the clock by dt and resumes every coroutine that became due
+	void Tick(float dt);
+	// Ticks with real time until every spawned task finished, sleeping while all of them wait
+	void Run();
+	bool HasTasks() const
+	{
+		return !tasks_.empty();
+	}
+	double GetTime() const
+	{
+		return now_;
+	}
+	// Seconds a driver may sleep before the next tick has anything to resume
+	double TimeUntilNextWake() const;
+	std::pmr::memory_resource* GetFrameResource() const
+	{
+		return frame_resource_;
+	}
+
+	auto NextFrame()
+	{
+		struct Awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { scheduler_->next_frame_.push_back(handle); }
+			void await_resume() const noexcept {}
+			Scheduler* scheduler_;
+		};
+		return Awaiter{ this };
+	}
+	auto Delay(float seconds)
+	{
+		struct Awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { scheduler_->AddTimer(seconds_, handle); }
+			void await_resume() const noexcept {}
+			Scheduler* scheduler_;
+			float seconds_;
+		};
+		return Awaiter{ this, seconds };
+	}
+	// The condition is polled every poll_interval seconds, like a timer; between polls the
+	// waiting coroutine wakes nothing, so a scheduler with only such waits sleeps until the next poll
+	auto WaitUntil(std::function<bool()> condition, float poll_interval)
+	{
+		struct Awaiter
+		{
+			bool await_ready() const { return condition_(); }
+			void await_suspend(std::coroutine_handle<> handle) { scheduler_->AddTimer(poll_interval_, handle, std::move(condition_)); }
+			void await_resume() const noexcept {}
+			Scheduler* scheduler_;
+			std::function<bool()> condition_;
+			float poll_interval_;
+		};
+		return Awaiter{ this, std::move(condition), poll_interval };
+	}
+
+private:
+	friend class Task;
+
+	struct SleepingTask
+	{
+		bool operator>(const SleepingTask& rhs) const
+		{
+			return wake_time_ != rhs.wake_time_ ? wake_time_ > rhs.wake_time_ : sequence_ > rhs.sequence_;
+		}
+		double wake_time_;
+		unsigned long long sequence_;
+		std::coroutine_handle<> handle_;
+		// Set for WaitUntil, which sleeps again for poll_interval_ while the condition is false
+		std::function<bool()> condition_;
+		float poll_interval_;
+	};
+
+	void AddTimer(float seconds, std::coroutine_handle<> handle, std::function<bool()> condition = {});
+	void OnTaskFinished(std::coroutine_handle<Task::promise_type> handle);
+
+private:
+	std::pmr::memory_resource* frame_resource_;
+	double now_ = 0.0;
+	unsigned long long timer_sequence_ = 0;
+	std::vector<std::coroutine_handle<Task::promise_type>> tasks_;
+	std::vector<std::coroutine_handle<Task::promise_type>> finished_;
+	std::vector<std::coroutine_handle<>> next_frame_;
+	std::vector<std::coroutine_handle<>> resuming_;
+	std::priority_queue<SleepingTask, std::vector<SleepingTask>, std::greater<SleepingTask>> timers_;
+	std::vector<SleepingTask> polled_;
+};
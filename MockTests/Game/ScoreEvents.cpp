@@ -0,0 +1,15 @@
+#include "ScoreEvents.h"
+
+void ScoreEventBuffer::Subscribe(Listener listener)
+{
+	listeners_.push_back(std::move(listener));
+}
+
+void ScoreEventBuffer::Publish() const
+{
+	if (events_.empty())
+		return;
+
+	for (const auto& listener : listeners_)
+		listener(events_);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <memory_resource>
+#include <span>
+#include <functional>
+
+struct ScoreEvent
+{
+	enum class Type { Score, ScoreLost, LifeLost };
+
+	int complement_index_;
+	int player_index_;
+	Type type_;
+	int value_;
+	float time_on_board_ = 0.0f;
+};
+
+// Collects the score events of one tick and hands them to every listener as a single batch
+class ScoreEventBuffer
+{
+public:
+	using Listener = std::function<void(std::span<const ScoreEvent>)>;
+
+	explicit ScoreEventBuffer(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		:
+		events_(resource),
+		listeners_(resource)
+	{
+	}
+
+	void Push(const ScoreEvent& event)
+	{
+		events_.push_back(event);
+	}
+	void Clear()
+	{
+		events_.clear();
+	}
+	bool IsEmpty() const
+	{
+		return events_.empty();
+	}
+	std::span<const ScoreEvent> GetEvents() const
+	{
+		return events_;
+	}
+
+	void Subscribe(Listener listener);
+	void Publish() const;
+private:
+	std::pmr::vector<ScoreEvent> events_;
+	std::pmr::vector<Listener> listeners_;
+};
@@ -0,0 +1,610 @@
+#include "SessionRecording.h"
+#include "BlockCompression.h"
+#include "World.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include "WinInclude.h"
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+constexpr char FILE_MAGIC[8] = { 'M', 'T', 'R', 'E', 'C', '0', '0', '1' };
+constexpr char INDEX_MAGIC[8] = { 'M', 'T', 'I', 'D', 'X', '0', '0', '1' };
+// Compressed chunks of a stream gather in a staging buffer and reach the disk in large writes
+constexpr std::size_t STAGING_SIZE = 1 << 18;
+// Chunk layout: first tick (8 bytes), tick count (4 bytes), board, score, score lost, lifes
+constexpr std::size_t TICK_COUNT_OFFSET = 8;
+
+namespace
+{
+	template<typename T, typename Bytes>
+	void WritePod(Bytes& out, T value)
+	{
+		const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadPod(const std::uint8_t*& data, const std::uint8_t* end, T& value)
+	{
+		if (std::size_t(end - data) < sizeof(T))
+			return false;
+
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+
+	template<typename T>
+	bool ReadPod(std::ifstream& file, T& value)
+	{
+		return bool(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	// Write-only file written at explicit offsets, straight through the OS with no stream buffer of its own
+	class OutputFile
+	{
+	public:
+		OutputFile() = default;
+		OutputFile(const OutputFile&) = delete;
+		OutputFile& operator=(const OutputFile&) = delete;
+		~OutputFile()
+		{
+			Close();
+		}
+
+		bool Open(const std::string& path)
+		{
+#ifdef _WIN32
+			handle_ = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			return handle_ != INVALID_HANDLE_VALUE;
+#else
+			fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			return fd_ != -1;
+#endif
+		}
+
+		bool WriteAt(std::uint64_t offset, const std::uint8_t* data, std::size_t size)
+		{
+			while (size > 0)
+			{
+#ifdef _WIN32
+				OVERLAPPED position{};
+				position.Offset = DWORD(offset);
+				position.OffsetHigh = DWORD(offset >> 32);
+				DWORD written = 0;
+				if (!WriteFile(handle_, data, DWORD(std::min<std::size_t>(size, 1u << 30)), &written, &position) || written == 0)
+					return false;
+#else
+				const ssize_t written = ::pwrite(fd_, data, size, off_t(offset));
+				if (written == -1 && errno == EINTR)
+					continue;
+				if (written <= 0)
+					return false;
+#endif
+				offset += std::uint64_t(written);
+				data += written;
+				size -= std::size_t(written);
+			}
+			return true;
+		}
+
+		bool Close()
+		{
+#ifdef _WIN32
+			const bool closed = handle_ == INVALID_HANDLE_VALUE || CloseHandle(handle_);
+			handle_ = INVALID_HANDLE_VALUE;
+#else
+			const bool closed = fd_ == -1 || ::close(fd_) == 0;
+			fd_ = -1;
+#endif
+			return closed;
+		}
+	private:
+#ifdef _WIN32
+		HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+		int fd_ = -1;
+#endif
+	};
+}
+
+class RecordingWriter::Stream
+{
+public:
+	Stream(std::string path)
+		:
+		path_(std::move(path))
+	{
+	}
+	Stream(const Stream&) = delete;
+	Stream& operator=(const Stream&) = delete;
+
+	const std::string& GetPath() const
+	{
+		return path_;
+	}
+
+	// Each step returns an error message on failure, after which the stream ignores the rest
+	std::string Open(std::span<const std::uint8_t> header)
+	{
+		if (!file_.Open(path_))
+			return Fail("cannot open the file");
+
+		staging_.reserve(STAGING_SIZE);
+		return Write(header.data(), header.size());
+	}
+
+	std::string WriteChunk(std::uint64_t first_tick, const std::vector<std::uint8_t>& raw)
+	{
+		if (failed_)
+			return {};
+
+		const std::vector<std::uint8_t> compressed = CompressBlock(raw);
+
+		index_.emplace_back(first_tick, staged_offset_);
+
+		std::vector<std::uint8_t> frame;
+		WritePod<std::uint32_t>(frame, std::uint32_t(compressed.size()));
+		WritePod<std::uint32_t>(frame, std::uint32_t(raw.size()));
+		std::string error = Write(frame.data(), frame.size());
+		if (error.empty())
+			error = Write(compressed.data(), compressed.size());
+		return error;
+	}
+
+	std::string Finish(std::uint64_t tick_count)
+	{
+		if (failed_)
+			return {};
+
+		std::vector<std::uint8_t> footer;
+		for (const auto& [first_tick, offset] : index_)
+		{
+			WritePod<std::uint64_t>(footer, first_tick);
+			WritePod<std::uint64_t>(footer, offset);
+		}
+		WritePod<std::uint64_t>(footer, tick_count);
+		WritePod<std::uint64_t>(footer, index_.size());
+		footer.insert(footer.end(), INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+
+		std::string error = Write(footer.data(), footer.size());
+		if (error.empty())
+			error = FlushStaging();
+		if (error.empty() && !file_.Close())
+			error = Fail("cannot close the file");
+		return error;
+	}
+private:
+	std::string Write(const std::uint8_t* data, std::size_t size)
+	{
+		staged_offset_ += size;
+
+		while (size > 0)
+		{
+			const std::size_t count = std::min(size, STAGING_SIZE - staging_.size());
+			staging_.insert(staging_.end(), data, data + count);
+			data += count;
+			size -= count;
+
+			if (staging_.size() == STAGING_SIZE)
+			{
+				std::string error = FlushStaging();
+				if (!error.empty())
+					return error;
+			}
+		}
+		return {};
+	}
+
+	std::string FlushStaging()
+	{
+		if (!file_.WriteAt(file_offset_, staging_.data(), staging_.size()))
+			return Fail("cannot write the file");
+
+		file_offset_ += staging_.size();
+		staging_.clear();
+		return {};
+	}
+
+	std::string Fail(std::string message)
+	{
+		failed_ = true;
+		file_.Close();
+		return message;
+	}
+
+private:
+	std::string path_;
+	OutputFile file_;
+	bool failed_ = false;
+	std::vector<std::uint8_t> staging_;
+	// Bytes already on disk, and bytes handed to the stream so far
+	std::uint64_t file_offset_ = 0;
+	std::uint64_t staged_offset_ = 0;
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> index_;
+};
+
+RecordingWriter::RecordingWriter(std::size_t max_queued_bytes, ErrorHandler on_error)
+	:
+	max_queued_bytes_(max_queued_bytes),
+	on_error_(std::move(on_error)),
+	thread_(&RecordingWriter::Run, this)
+{
+	if (!on_error_)
+		on_error_ = [](const std::string& path, const std::string& message) { std::cerr << "Recording " << path << ": " << message << '\n'; };
+}
+
+RecordingWriter::~RecordingWriter()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	wake_.notify_one();
+	thread_.join();
+}
+
+RecordingWriter& RecordingWriter::GetShared()
+{
+	static RecordingWriter writer;
+	return writer;
+}
+
+RecordingWriter::Stream* RecordingWriter::OpenStream(std::string path, Location2D extent)
+{
+	Stream* stream = new Stream(std::move(path));
+
+	std::vector<std::uint8_t> header;
+	header.insert(header.end(), FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+	WritePod<std::int32_t>(header, extent.x);
+	WritePod<std::int32_t>(header, extent.y);
+
+	Push(Job{ Job::Type::Open, stream, 0, std::move(header) });
+	return stream;
+}
+
+void RecordingWriter::WriteChunk(Stream* stream, std::uint64_t first_tick, std::vector<std::uint8_t> raw)
+{
+	Push(Job{ Job::Type::Chunk, stream, first_tick, std::move(raw) });
+}
+
+void RecordingWriter::FinishStream(Stream* stream, std::uint64_t tick_count)
+{
+	Push(Job{ Job::Type::Finish, stream, tick_count, {} });
+}
+
+void RecordingWriter::AppendToFile(std::string path, std::string text)
+{
+	Push(Job{ Job::Type::Append, nullptr, 0, std::vector<std::uint8_t>(text.begin(), text.end()), std::move(path) });
+}
+
+void RecordingWriter::Flush()
+{
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+}
+
+void RecordingWriter::Push(Job job)
+{
+	{
+		std::unique_lock lock(mutex_);
+		// A job larger than the whole bound still goes through once the queue is empty
+		space_.wait(lock, [this, &job]() { return queued_bytes_ == 0 || queued_bytes_ + job.data_.size() <= max_queued_bytes_; });
+
+		queued_bytes_ += job.data_.size();
+		queue_.push_back(std::move(job));
+	}
+	wake_.notify_one();
+}
+
+void RecordingWriter::Run()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock lock(mutex_);
+			busy_ = false;
+			if (queue_.empty())
+				idle_.notify_all();
+
+			wake_.wait(lock, [this]() { return !queue_.empty() || stopping_; });
+
+			if (queue_.empty())
+				break;
+
+			job = std::move(queue_.front());
+			queue_.pop_front();
+			queued_bytes_ -= job.data_.size();
+			busy_ = true;
+		}
+		space_.notify_all();
+
+		std::string error;
+		switch (job.type_)
+		{
+		case Job::Type::Open:
+			error = job.stream_->Open(job.data_);
+			break;
+		case Job::Type::Chunk:
+			error = job.stream_->WriteChunk(job.tick_, job.data_);
+			break;
+		case Job::Type::Finish:
+			error = job.stream_->Finish(job.tick_);
+			break;
+		case Job::Type::Append:
+		{
+			std::ofstream file(job.path_, std::ios::binary | std::ios::app);
+			if (!file.write(reinterpret_cast<const char*>(job.data_.data()), std::streamsize(job.data_.size())))
+				error = "cannot append to the file";
+			break;
+		}
+		}
+
+		if (!error.empty())
+			on_error_(job.stream_ ? job.stream_->GetPath() : job.path_, error);
+		if (job.type_ == Job::Type::Finish)
+			delete job.stream_;
+	}
+}
+
+SessionRecorder::SessionRecorder(std::string_view path, IWorld& world, const IGameStatus& game_status, int ticks_per_chunk, RecordingWriter& writer, std::pmr::memory_resource* resource)
+	:
+	world_(world),
+	game_status_(game_status),
+	extent_(world.GetExtent()),
+	ticks_per_chunk_(std::max(ticks_per_chunk, 1)),
+	previous_board_(size_t(extent_.x) * extent_.y, ' ', resource),
+	tick_events_(resource),
+	changed_cells_(resource),
+	tick_cells_(resource),
+	chunk_(resource),
+	writer_(writer),
+	stream_(writer.OpenStream(std::string(path), extent_))
+{
+	for (int i = 0; i < int(previous_board_.size()); i++)
+		previous_board_[i] = world_.GetCell(i);
+
+	world_.TrackChanges();
+	BeginChunk();
+}
+
+SessionRecorder::~SessionRecorder()
+{
+	Close();
+}
+
+void SessionRecorder::AddEvents(std::span<const ScoreEvent> events)
+{
+	tick_events_.insert(tick_events_.end(), events.begin(), events.end());
+}
+
+void SessionRecorder::RecordTick()
+{
+	if (closed_)
+		return;
+
+	tick_++;
+
+	changed_cells_.clear();
+	world_.TakeChangedCells(changed_cells_);
+
+	tick_cells_.clear();
+	for (int index : changed_cells_)
+	{
+		const char cell = world_.GetCell(index);
+		if (cell != previous_board_[index])
+		{
+			previous_board_[index] = cell;
+			tick_cells_.emplace_back(index, cell);
+		}
+	}
+
+	WriteVarint(chunk_, tick_cells_.size());
+	for (const auto& [index, cell] : tick_cells_)
+	{
+		WriteVarint(chunk_, std::uint64_t(index));
+		chunk_.push_back(std::uint8_t(cell));
+	}
+
+	WriteVarint(chunk_, tick_events_.size());
+	for (const auto& event : tick_events_)
+	{
+		chunk_.push_back(std::uint8_t(event.type_));
+		WriteVarint(chunk_, std::uint64_t(event.player_index_));
+		WriteVarint(chunk_, std::uint64_t(event.value_));
+	}
+	tick_events_.clear();
+
+	// The next keyframe is the state right after this tick, status included
+	if (++ticks_in_chunk_ == ticks_per_chunk_)
+	{
+		EndChunk();
+		BeginChunk();
+	}
+}
+
+void SessionRecorder::Close()
+{
+	if (closed_)
+		return;
+
+	// A recording always holds at least one chunk, so the initial state can be sought
+	if (ticks_in_chunk_ > 0 || tick_ == 0)
+		EndChunk();
+	closed_ = true;
+
+	writer_.FinishStream(stream_, tick_);
+	stream_ = nullptr;
+}
+
+void SessionRecorder::BeginChunk()
+{
+	const StatusSnapshot status = game_status_.GetSnapshot();
+
+	chunk_.clear();
+	WritePod<std::uint64_t>(chunk_, tick_ + 1);
+	WritePod<std::uint32_t>(chunk_, 0);
+	chunk_.insert(chunk_.end(), previous_board_.begin(), previous_board_.end());
+	WritePod<std::int32_t>(chunk_, status.score_);
+	WritePod<std::int32_t>(chunk_, status.score_lost_);
+	WritePod<std::int32_t>(chunk_, status.player_lifes_);
+}
+
+void SessionRecorder::EndChunk()
+{
+	const std::uint32_t tick_count = std::uint32_t(ticks_in_chunk_);
+	std::memcpy(chunk_.data() + TICK_COUNT_OFFSET, &tick_count, sizeof(tick_count));
+
+	writer_.WriteChunk(stream_, tick_ + 1 - tick_count, std::vector<std::uint8_t>(chunk_.begin(), chunk_.end()));
+	chunk_.clear();
+	ticks_in_chunk_ = 0;
+}
+
+SessionReader::SessionReader(const std::string& path)
+	:
+	file_(path, std::ios::binary)
+{
+	constexpr std::uint64_t header_size = sizeof(FILE_MAGIC) + 2 * sizeof(std::int32_t);
+	constexpr std::uint64_t trailer_size = 2 * sizeof(std::uint64_t) + sizeof(INDEX_MAGIC);
+	constexpr std::uint64_t entry_size = 2 * sizeof(std::uint64_t);
+	constexpr std::uint64_t frame_size = 2 * sizeof(std::uint32_t);
+
+	file_.seekg(0, std::ios::end);
+	const std::streamoff file_size = file_.tellg();
+	if (file_size < std::streamoff(header_size + trailer_size))
+		return;
+	file_.seekg(0);
+
+	char magic[8];
+	std::int32_t extent_x, extent_y;
+	if (!file_.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 ||
+		!ReadPod(file_, extent_x) || !ReadPod(file_, extent_y) || extent_x <= 0 || extent_y <= 0)
+		return;
+
+	extent_ = { extent_x, extent_y };
+
+	std::uint64_t chunk_count;
+	file_.seekg(file_size - std::streamoff(trailer_size));
+	if (!ReadPod(file_, tick_count_) || !ReadPod(file_, chunk_count) ||
+		!file_.read(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0)
+		return;
+
+	// Everything below comes from the file, so it is checked against the file's real size
+	// before it sizes anything: the index fits between the header and the trailer, and the
+	// chunks it points at come in order between the header and the index
+	const std::uint64_t body_size = std::uint64_t(file_size) - header_size - trailer_size;
+	if (chunk_count == 0 || chunk_count > body_size / entry_size)
+		return;
+
+	chunks_end_ = std::uint64_t(file_size) - trailer_size - chunk_count * entry_size;
+	file_.seekg(std::streamoff(chunks_end_));
+	index_.resize(chunk_count);
+
+	std::uint64_t next_tick = 0;
+	std::uint64_t next_offset = header_size;
+	for (auto& [first_tick, offset] : index_)
+	{
+		if (!ReadPod(file_, first_tick) || !ReadPod(file_, offset) ||
+			first_tick < next_tick || offset < next_offset || offset > chunks_end_ - frame_size)
+		{
+			index_.clear();
+			return;
+		}
+
+		next_tick = first_tick + 1;
+		next_offset = offset + frame_size;
+	}
+
+	open_ = true;
+}
+
+bool SessionReader::SeekToTick(std::uint64_t tick)
+{
+	if (!open_ || tick > tick_count_)
+		return false;
+
+	// Last chunk whose keyframe, the state after first_tick - 1, is not past the tick
+	auto entry = std::upper_bound(index_.begin(), index_.end(), tick + 1,
+		[](std::uint64_t value, const auto& chunk) { return value < chunk.first; });
+	if (entry == index_.begin())
+		return false;
+	--entry;
+
+	const std::size_t board_size = size_t(extent_.x) * extent_.y;
+	const std::size_t keyframe_size = sizeof(std::uint64_t) + sizeof(std::uint32_t) + board_size + 3 * sizeof(std::int32_t);
+
+	std::uint32_t compressed_size, raw_size;
+	file_.clear();
+	file_.seekg(std::streamoff(entry->second));
+	if (!ReadPod(file_, compressed_size) || !ReadPod(file_, raw_size) ||
+		compressed_size > chunks_end_ - entry->second - 2 * sizeof(std::uint32_t) || raw_size < keyframe_size)
+		return false;
+
+	std::vector<std::uint8_t> compressed(compressed_size);
+	std::vector<std::uint8_t> raw;
+	if (!file_.read(reinterpret_cast<char*>(compressed.data()), compressed_size) || !DecompressBlock(compressed, raw_size, raw))
+		return false;
+
+	const std::uint8_t* data = raw.data();
+	const std::uint8_t* end = data + raw.size();
+
+	std::uint64_t first_tick;
+	std::uint32_t tick_count;
+	std::int32_t score, score_lost, player_lifes;
+	if (!ReadPod(data, end, first_tick) || !ReadPod(data, end, tick_count) || std::size_t(end - data) < board_size)
+		return false;
+
+	board_.assign(reinterpret_cast<const char*>(data), board_size);
+	data += board_size;
+
+	if (!ReadPod(data, end, score) || !ReadPod(data, end, score_lost) || !ReadPod(data, end, player_lifes))
+		return false;
+
+	status_ = GameStatus(score, score_lost, player_lifes);
+	tick_events_.clear();
+
+	if (tick + 1 - first_tick > tick_count)
+		return false;
+
+	for (std::uint64_t t = first_tick; t <= tick; t++)
+	{
+		std::uint64_t cell_count;
+		if (!ReadVarint(data, end, cell_count))
+			return false;
+
+		for (std::uint64_t c = 0; c < cell_count; c++)
+		{
+			std::uint64_t index;
+			if (!ReadVarint(data, end, index) || index >= board_size || data == end)
+				return false;
+			board_[index] = char(*data++);
+		}
+
+		std::uint64_t event_count;
+		if (!ReadVarint(data, end, event_count))
+			return false;
+
+		tick_events_.clear();
+		for (std::uint64_t e = 0; e < event_count; e++)
+		{
+			std::uint64_t player_index, value;
+			if (data == end)
+				return false;
+			const auto type = ScoreEvent::Type(*data++);
+			if (!ReadVarint(data, end, player_index) || !ReadVarint(data, end, value))
+				return false;
+			tick_events_.push_back(ScoreEvent{ -1, int(player_index), type, int(value) });
+		}
+
+		status_.ApplyEvents(tick_events_);
+	}
+
+	return true;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Location2D.h"
+#include "GameStatus.h"
+#include "ScoreEvents.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class IWorld;
+
+// One background thread that opens, compresses and writes the chunks of every recording in the
+// process, fed by a queue. Sessions only hand over encoded chunks, so they never wait on the disk
+// and any number of them share the one I/O thread, which also appends the sessions' telemetry
+// summaries to their files. The queue holds at most max_queued_bytes of
+// chunks: past that, sessions wait for the disk to catch up instead of growing it without end.
+class RecordingWriter
+{
+public:
+	class Stream;
+	// Called on the I/O thread with the recording's path when opening or writing it fails;
+	// the rest of that recording is dropped
+	using ErrorHandler = std::function<void(const std::string& path, const std::string& message)>;
+
+	static constexpr std::size_t DEFAULT_MAX_QUEUED_BYTES = std::size_t(64) << 20;
+
+	// Errors go to std::cerr unless a handler is given
+	explicit RecordingWriter(std::size_t max_queued_bytes = DEFAULT_MAX_QUEUED_BYTES, ErrorHandler on_error = {});
+	RecordingWriter(const RecordingWriter&) = delete;
+	RecordingWriter& operator=(const RecordingWriter&) = delete;
+	// Finishes everything still queued
+	~RecordingWriter();
+
+	static RecordingWriter& GetShared();
+
+	// Queues creating the file; the handle is valid until passed to FinishStream
+	Stream* OpenStream(std::string path, Location2D extent);
+	void WriteChunk(Stream* stream, std::uint64_t first_tick, std::vector<std::uint8_t> raw);
+	// Queues writing the chunk index and closing the file
+	void FinishStream(Stream* stream, std::uint64_t tick_count);
+	// Queues appending the text to the file, creating it if needed
+	void AppendToFile(std::string path, std::string text);
+	// Waits until everything queued so far is on disk
+	void Flush();
+private:
+	struct Job
+	{
+		enum class Type { Open, Chunk, Finish, Append };
+
+		Type type_;
+		Stream* stream_;
+		std::uint64_t tick_;
+		std::vector<std::uint8_t> data_;
+		// Only for Append, which has no stream
+		std::string path_;
+	};
+
+	void Push(Job job);
+	void Run();
+
+private:
+	std::size_t max_queued_bytes_;
+	ErrorHandler on_error_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable idle_;
+	std::condition_variable space_;
+	std::deque<Job> queue_;
+	std::size_t queued_bytes_ = 0;
+	bool busy_ = false;
+	bool stopping_ = false;
+	std::thread thread_;
+};
+
+// Streams a session to disk as a header, a run of compressed chunks and a chunk index.
+// Each chunk opens with a keyframe of the board and status, then holds the cell changes
+// and score events of up to ticks_per_chunk ticks, so any tick is rebuilt from one chunk.
+// Chunks are encoded on the simulation thread and handed to a RecordingWriter for the rest.
+class SessionRecorder
+{
+public:
+	static constexpr int DEFAULT_TICKS_PER_CHUNK = 256;
+
+	// Tracks the world's changes from here on; the first chunk's keyframe is the current state.
+	// The recorder's buffers are allocated from the given resource, while a finished chunk is
+	// copied to the heap for the writer, as it may be written after the session is gone.
+	SessionRecorder(std::string_view path, IWorld& world, const IGameStatus& game_status, int ticks_per_chunk = DEFAULT_TICKS_PER_CHUNK,
+		RecordingWriter& writer = RecordingWriter::GetShared(), std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	SessionRecorder(const SessionRecorder&) = delete;
+	SessionRecorder& operator=(const SessionRecorder&) = delete;
+	~SessionRecorder();
+
+	// Queues score events for the tick being recorded
+	void AddEvents(std::span<const ScoreEvent> events);
+	// Ends a tick, storing every cell written since the previous one that ended up different
+	void RecordTick();
+	// Hands the open chunk and the index to the writer without waiting for them
+	void Close();
+
+	std::uint64_t GetTickCount() const
+	{
+		return tick_;
+	}
+private:
+	void BeginChunk();
+	void EndChunk();
+
+private:
+	IWorld& world_;
+	const IGameStatus& game_status_;
+	Location2D extent_;
+	int ticks_per_chunk_;
+	std::pmr::string previous_board_;
+	std::pmr::vector<ScoreEvent> tick_events_;
+	std::pmr::vector<int> changed_cells_;
+	std::pmr::vector<std::pair<int, char>> tick_cells_;
+	std::pmr::vector<std::uint8_t> chunk_;
+	int ticks_in_chunk_ = 0;
+	std::uint64_t tick_ = 0;
+	bool closed_ = false;
+	RecordingWriter& writer_;
+	RecordingWriter::Stream* stream_;
+};
+
+// Random access to a recording. Seeking decodes only the chunk holding the requested tick.
+// A truncated or corrupt file leaves the reader closed or fails the seek, never reading past the file.
+class SessionReader
+{
+public:
+	explicit SessionReader(const std::string& path);
+
+	bool IsOpen() const
+	{
+		return open_;
+	}
+	Location2D GetExtent() const
+	{
+		return extent_;
+	}
+	std::uint64_t GetTickCount() const
+	{
+		return tick_count_;
+	}
+
+	// Rebuilds the board and status as they were after the given tick; tick 0 is the initial state
+	bool SeekToTick(std::uint64_t tick);
+	const std::string& GetBoard() const
+	{
+		return board_;
+	}
+	const GameStatus& GetStatus() const
+	{
+		return status_;
+	}
+	// Score events of the tick last sought to
+	const std::vector<ScoreEvent>& GetTickEvents() const
+	{
+		return tick_events_;
+	}
+private:
+	std::ifstream file_;
+	bool open_ = false;
+	Location2D extent_{};
+	std::uint64_t tick_count_ = 0;
+	// Where the chunks stop and the index starts
+	std::uint64_t chunks_end_ = 0;
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> index_;
+	std::string board_;
+	GameStatus status_;
+	std::vector<ScoreEvent> tick_events_;
+};
@@ -0,0 +1,272 @@
+#include "ShardRuntime.h"
+#include "GameLoop.h"
+#include "Scheduler.h"
+#include "Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include "WinInclude.h"
+#else
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Large enough that a whole GameLoop, telemetry histograms included, is pooled
+constexpr size_t ARENA_LARGEST_POOL_BLOCK = 1 << 16;
+
+namespace
+{
+	thread_local int current_shard = -1;
+
+	void PinCurrentThread(int core)
+	{
+#ifdef _WIN32
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (core % 64));
+#else
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		CPU_SET(core, &cpu_set);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+	}
+
+	// Counts the hardware cache misses of the thread that created it, in user space only.
+	// Windows has no such counter without a kernel driver, so it is never available there.
+	class CacheMissCounter
+	{
+	public:
+		CacheMissCounter()
+		{
+#ifndef _WIN32
+			perf_event_attr attr{};
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+		}
+		CacheMissCounter(const CacheMissCounter&) = delete;
+		CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+		~CacheMissCounter()
+		{
+#ifndef _WIN32
+			if (fd_ != -1)
+				close(fd_);
+#endif
+		}
+
+		// Empty when the counter is unavailable
+		std::optional<std::uint64_t> Read() const
+		{
+#ifndef _WIN32
+			std::uint64_t value;
+			if (fd_ != -1 && read(fd_, &value, sizeof(value)) == sizeof(value))
+				return value;
+#endif
+			return std::nullopt;
+		}
+	private:
+		int fd_ = -1;
+	};
+
+	Task RunSession(Scheduler& scheduler, GameLoop* session, std::vector<GameLoop*>* finished)
+	{
+		co_await session->Session(scheduler);
+		finished->push_back(session);
+	}
+}
+
+ShardArena::ShardArena(int shard_index, size_t largest_pool_block)
+	:
+	shard_index_(shard_index),
+	pool_(std::pmr::pool_options{ 0, largest_pool_block }, &upstream_)
+{
+}
+
+void ShardArena::SetCurrentShard(int shard_index)
+{
+	current_shard = shard_index;
+}
+
+void* ShardArena::do_allocate(size_t bytes, size_t alignment)
+{
+	allocations_.fetch_add(1, std::memory_order_relaxed);
+	bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+	if (current_shard != shard_index_)
+		cross_shard_allocations_.fetch_add(1, std::memory_order_relaxed);
+
+	return pool_.allocate(bytes, alignment);
+}
+
+void ShardArena::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	pool_.deallocate(p, bytes, alignment);
+}
+
+void* ShardArena::Upstream::do_allocate(size_t bytes, size_t alignment)
+{
+	void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	reserved_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+	return p;
+}
+
+void ShardArena::Upstream::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	reserved_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+struct ShardRuntime::Shard
+{
+	Shard(int index, int core)
+		:
+		index_(index),
+		core_(core),
+		arena_(index, ARENA_LARGEST_POOL_BLOCK)
+	{
+	}
+
+	int index_;
+	int core_;
+	ShardArena arena_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::vector<SessionFactory> pending_;
+	bool stopping_ = false;
+	std::atomic<std::uint64_t> sessions_started_ = 0;
+	std::atomic<bool> cache_misses_counted_ = false;
+	std::atomic<std::uint64_t> cache_misses_ = 0;
+	std::thread thread_;
+};
+
+ShardRuntime::ShardRuntime(int shard_count)
+{
+	const int cores = std::max(int(std::thread::hardware_concurrency()), 1);
+	if (shard_count <= 0)
+		shard_count = cores;
+
+	for (int i = 0; i < shard_count; i++)
+		shards_.push_back(std::make_unique<Shard>(i, i % cores));
+
+	for (auto& shard : shards_)
+		shard->thread_ = std::thread(&ShardRuntime::RunShard, std::ref(*shard));
+}
+
+ShardRuntime::~ShardRuntime()
+{
+	Shutdown();
+}
+
+int ShardRuntime::StartSession(SessionFactory factory)
+{
+	if (!factory)
+	{
+		factory = [](std::pmr::polymorphic_allocator<> allocator)
+			{
+				return allocator.new_object<GameLoop>(allocator.resource());
+			};
+	}
+
+	const int index = next_shard_.fetch_add(1, std::memory_order_relaxed) % int(shards_.size());
+	Shard& shard = *shards_[index];
+	{
+		std::lock_guard lock(shard.mutex_);
+		shard.pending_.push_back(std::move(factory));
+	}
+	shard.wake_.notify_one();
+
+	return index;
+}
+
+void ShardRuntime::Shutdown()
+{
+	for (auto& shard : shards_)
+	{
+		{
+			std::lock_guard lock(shard->mutex_);
+			shard->stopping_ = true;
+		}
+		shard->wake_.notify_one();
+	}
+
+	for (auto& shard : shards_)
+	{
+		if (shard->thread_.joinable())
+			shard->thread_.join();
+	}
+}
+
+std::vector<ShardRuntime::ShardStats> ShardRuntime::GetStats() const
+{
+	std::vector<ShardStats> stats;
+	for (const auto& shard : shards_)
+	{
+		stats.push_back(ShardStats{
+			shard->sessions_started_.load(std::memory_order_relaxed),
+			shard->arena_.GetAllocations(),
+			shard->arena_.GetBytesAllocated(),
+			shard->arena_.GetCrossShardAllocations(),
+			shard->arena_.GetReservedBytes(),
+			shard->cache_misses_counted_.load(std::memory_order_acquire) ? std::optional(shard->cache_misses_.load(std::memory_order_relaxed)) : std::nullopt });
+	}
+	return stats;
+}
+
+void ShardRuntime::RunShard(Shard& shard)
+{
+	PinCurrentThread(shard.core_);
+	ShardArena::SetCurrentShard(shard.index_);
+
+	CacheMissCounter cache_misses;
+
+	std::pmr::polymorphic_allocator<> allocator(&shard.arena_);
+	Scheduler scheduler(&shard.arena_);
+	Timer timer{};
+	std::vector<SessionFactory> pending;
+	std::vector<GameLoop*> finished;
+
+	while (true)
+	{
+		{
+			std::unique_lock lock(shard.mutex_);
+
+			auto has_work = [&]() { return !shard.pending_.empty() || (shard.stopping_ && !scheduler.HasTasks()); };
+			if (scheduler.HasTasks())
+				shard.wake_.wait_for(lock, std::chrono::duration<double>(scheduler.TimeUntilNextWake()), has_work);
+			else
+				shard.wake_.wait(lock, has_work);
+
+			if (shard.stopping_ && shard.pending_.empty() && !scheduler.HasTasks())
+				break;
+
+			pending.swap(shard.pending_);
+		}
+
+		for (auto& factory : pending)
+		{
+			scheduler.Spawn(RunSession(scheduler, factory(allocator), &finished));
+			shard.sessions_started_.fetch_add(1, std::memory_order_relaxed);
+		}
+		pending.clear();
+
+		scheduler.Tick(timer.Tick());
+		if (const std::optional<std::uint64_t> count = cache_misses.Read())
+		{
+			shard.cache_misses_.store(*count, std::memory_order_relaxed);
+			shard.cache_misses_counted_.store(true, std::memory_order_release);
+		}
+
+		for (GameLoop* session : finished)
+			allocator.delete_object(session);
+		finished.clear();
+	}
+}
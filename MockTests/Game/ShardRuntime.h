@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+class GameLoop;
+
+// Memory of one shard. Sessions draw from a pool whose blocks are first touched by the shard's
+// pinned thread and so stay local to its core and NUMA node. Freed blocks return to the pool
+// and are reused by later sessions; requests above largest_pool_block bypass the pool and go
+// straight back to the heap. Allocations made from any other thread are counted as cross shard.
+class ShardArena : public std::pmr::memory_resource
+{
+public:
+	ShardArena(int shard_index, size_t largest_pool_block);
+
+	// Marks the calling thread as the worker of the given shard
+	static void SetCurrentShard(int shard_index);
+
+	std::uint64_t GetAllocations() const
+	{
+		return allocations_.load(std::memory_order_relaxed);
+	}
+	std::uint64_t GetBytesAllocated() const
+	{
+		return bytes_allocated_.load(std::memory_order_relaxed);
+	}
+	std::uint64_t GetCrossShardAllocations() const
+	{
+		return cross_shard_allocations_.load(std::memory_order_relaxed);
+	}
+	// Bytes the arena currently holds from the heap, in use or pooled
+	std::uint64_t GetReservedBytes() const
+	{
+		return upstream_.GetReservedBytes();
+	}
+private:
+	// Heap behind the pool, keeping count of what it handed out
+	class Upstream : public std::pmr::memory_resource
+	{
+	public:
+		std::uint64_t GetReservedBytes() const
+		{
+			return reserved_bytes_.load(std::memory_order_relaxed);
+		}
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+	private:
+		std::atomic<std::uint64_t> reserved_bytes_ = 0;
+	};
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	int shard_index_;
+	Upstream upstream_;
+	std::pmr::synchronized_pool_resource pool_;
+	std::atomic<std::uint64_t> allocations_ = 0;
+	std::atomic<std::uint64_t> bytes_allocated_ = 0;
+	std::atomic<std::uint64_t> cross_shard_allocations_ = 0;
+};
+
+// Runs game sessions on one worker thread per shard, each pinned to its own core and
+// ticking its own Scheduler. A session is built on its shard's thread inside the shard arena,
+// and the coroutine frames the shard's Scheduler runs are allocated there as well.
+class ShardRuntime
+{
+public:
+	// Creates the session with the given allocator; the shard deletes it once it finished
+	using SessionFactory = std::function<GameLoop*(std::pmr::polymorphic_allocator<> allocator)>;
+
+	struct ShardStats
+	{
+		std::uint64_t sessions_started_;
+		std::uint64_t allocations_;
+		std::uint64_t bytes_allocated_;
+		std::uint64_t cross_shard_allocations_;
+		std::uint64_t reserved_bytes_;
+		// Hardware cache misses of the shard's thread. Empty when unavailable: always on Windows,
+		// which has no per-thread counter without a kernel driver, and on Linux when perf events
+		// are not permitted
+		std::optional<std::uint64_t> cache_misses_;
+	};
+
+	// A shard count of 0 uses one shard per hardware thread
+	ShardRuntime(int shard_count = 0);
+	ShardRuntime(const ShardRuntime&) = delete;
+	ShardRuntime& operator=(const ShardRuntime&) = delete;
+	~ShardRuntime();
+
+	// Queues a session on the next shard in turn and returns that shard's index
+	int StartSession(SessionFactory factory = {});
+	// Waits for every running session to finish and stops the worker threads
+	void Shutdown();
+
+	int GetShardCount() const
+	{
+		return int(shards_.size());
+	}
+	std::vector<ShardStats> GetStats() const;
+private:
+	struct Shard;
+
+	static void RunShard(Shard& shard);
+
+private:
+	std::vector<std::unique_ptr<Shard>> shards_;
+	std::atomic<int> next_shard_ = 0;
+};
@@ -0,0 +1,146 @@
+#include "Telemetry.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+
+void Histogram::Record(std::uint64_t value)
+{
+	counts_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+	count_.fetch_add(1, std::memory_order_relaxed);
+
+	std::uint64_t max = max_.load(std::memory_order_relaxed);
+	while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+std::uint64_t Histogram::ValueAtPercentile(double percentile) const
+{
+	const std::uint64_t count = GetCount();
+	if (count == 0)
+		return 0;
+
+	const std::uint64_t target = std::max<std::uint64_t>(std::uint64_t(std::ceil(percentile / 100.0 * double(count))), 1);
+
+	std::uint64_t seen = 0;
+	for (int i = 0; i < BUCKETS; i++)
+	{
+		seen += counts_[i].load(std::memory_order_relaxed);
+		if (seen >= target)
+			return std::min(BucketUpperBound(i), GetMax());
+	}
+
+	return GetMax();
+}
+
+void Histogram::Reset()
+{
+	for (auto& bucket : counts_)
+		bucket.store(0, std::memory_order_relaxed);
+	count_.store(0, std::memory_order_relaxed);
+	max_.store(0, std::memory_order_relaxed);
+}
+
+std::string Histogram::Summary() const
+{
+	return std::format("count={} p50={} p90={} p99={} p99.9={} max={}",
+		GetCount(), ValueAtPercentile(50.0), ValueAtPercentile(90.0), ValueAtPercentile(99.0), ValueAtPercentile(99.9), GetMax());
+}
+
+int Histogram::BucketIndex(std::uint64_t value)
+{
+	// Keep the top SUB_BUCKET_BITS + 1 bits; the bits shifted out select the magnitude
+	int magnitude = std::max(int(std::bit_width(value)) - SUB_BUCKET_BITS - 1, 0);
+	if (magnitude > MAX_MAGNITUDE)
+		return BUCKETS - 1;
+
+	return magnitude * SUB_BUCKETS + int(value >> magnitude);
+}
+
+std::uint64_t Histogram::BucketUpperBound(int index)
+{
+	int magnitude = std::max(index / SUB_BUCKETS - 1, 0);
+	std::uint64_t sub_bucket = std::uint64_t(index - magnitude * SUB_BUCKETS);
+
+	return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+void PlayerTelemetry::RecordScoreEvent(const ScoreEvent& event)
+{
+	time_on_board_ms_.Record(std::uint64_t(event.time_on_board_ * 1000.0f));
+
+	switch (event.type_)
+	{
+	case ScoreEvent::Type::Score:
+		catches_.fetch_add(1, std::memory_order_relaxed);
+		break;
+	case ScoreEvent::Type::LifeLost:
+		wrong_catches_.fetch_add(1, std::memory_order_relaxed);
+		break;
+	case ScoreEvent::Type::ScoreLost:
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		break;
+	}
+}
+
+Telemetry::Telemetry(int players_count, std::pmr::memory_resource* resource)
+	:
+	players_(std::size_t(std::max(players_count, 0)), resource)
+{
+}
+
+void Telemetry::RecordInputLatency(std::chrono::steady_clock::duration latency)
+{
+	input_latency_us_.Record(std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+}
+
+void Telemetry::RecordScoreEvents(std::span<const ScoreEvent> events)
+{
+	for (const auto& event : events)
+	{
+		if (event.player_index_ >= 0 && event.player_index_ < GetPlayerCount())
+			players_[event.player_index_].RecordScoreEvent(event);
+	}
+}
+
+std::uint64_t Telemetry::GetCatches() const
+{
+	std::uint64_t catches = 0;
+	for (const auto& player : players_)
+		catches += player.GetCatches();
+	return catches;
+}
+
+std::uint64_t Telemetry::GetWrongCatches() const
+{
+	std::uint64_t wrong_catches = 0;
+	for (const auto& player : players_)
+		wrong_catches += player.GetWrongCatches();
+	return wrong_catches;
+}
+
+std::uint64_t Telemetry::GetMisses() const
+{
+	std::uint64_t misses = 0;
+	for (const auto& player : players_)
+		misses += player.GetMisses();
+	return misses;
+}
+
+std::string Telemetry::Summary(double session_time) const
+{
+	std::string summary = std::format("[{:.1f}s]\n", session_time);
+	summary += std::format("    input_latency_us {}\n", input_latency_us_.Summary());
+
+	for (int i = 0; i < GetPlayerCount(); i++)
+	{
+		const PlayerTelemetry& player = players_[i];
+		const std::uint64_t catches = player.GetCatches();
+		const std::uint64_t total = catches + player.GetWrongCatches() + player.GetMisses();
+
+		summary += std::format("    player {} time_on_board_ms {}\n", i, player.GetTimeOnBoard().Summary());
+		summary += std::format("    player {} catches={} wrong_catches={} misses={} catch_rate={:.3f}\n",
+			i, catches, player.GetWrongCatches(), player.GetMisses(), total == 0 ? 0.0 : double(catches) / double(total));
+	}
+
+	return summary;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ScoreEvents.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+// Log-linear histogram in the spirit of HdrHistogram. Every power of two is split into
+// SUB_BUCKETS linear buckets, which keeps values within ~3% using a fixed amount of memory.
+// Recording is lock-free and safe from any thread.
+class Histogram
+{
+public:
+	static constexpr int SUB_BUCKET_BITS = 5;
+	static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static constexpr int MAX_MAGNITUDE = 40;
+	static constexpr int BUCKETS = (MAX_MAGNITUDE + 2) * SUB_BUCKETS;
+
+	void Record(std::uint64_t value);
+	// Upper bound of the bucket holding the given percentile, 0 when empty
+	std::uint64_t ValueAtPercentile(double percentile) const;
+	std::uint64_t GetCount() const
+	{
+		return count_.load(std::memory_order_relaxed);
+	}
+	std::uint64_t GetMax() const
+	{
+		return max_.load(std::memory_order_relaxed);
+	}
+	void Reset();
+	// One line of count, p50, p90, p99, p99.9 and max
+	std::string Summary() const;
+private:
+	static int BucketIndex(std::uint64_t value);
+	static std::uint64_t BucketUpperBound(int index);
+
+private:
+	std::array<std::atomic<std::uint64_t>, BUCKETS> counts_{};
+	std::atomic<std::uint64_t> count_ = 0;
+	std::atomic<std::uint64_t> max_ = 0;
+};
+
+// Score event measurements of one player
+class PlayerTelemetry
+{
+public:
+	void RecordScoreEvent(const ScoreEvent& event);
+
+	const Histogram& GetTimeOnBoard() const
+	{
+		return time_on_board_ms_;
+	}
+	std::uint64_t GetCatches() const
+	{
+		return catches_.load(std::memory_order_relaxed);
+	}
+	std::uint64_t GetWrongCatches() const
+	{
+		return wrong_catches_.load(std::memory_order_relaxed);
+	}
+	std::uint64_t GetMisses() const
+	{
+		return misses_.load(std::memory_order_relaxed);
+	}
+private:
+	Histogram time_on_board_ms_;
+	std::atomic<std::uint64_t> catches_ = 0;
+	std::atomic<std::uint64_t> wrong_catches_ = 0;
+	std::atomic<std::uint64_t> misses_ = 0;
+};
+
+// Session measurements, exported as percentile summaries. Score events are kept apart per
+// player, by the event's player index; input latency is the local keyboard's.
+class Telemetry
+{
+public:
+	// Events of players past players_count are not counted
+	explicit Telemetry(int players_count = 1, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	void RecordInputLatency(std::chrono::steady_clock::duration latency);
+	void RecordScoreEvents(std::span<const ScoreEvent> events);
+
+	const Histogram& GetInputLatency() const
+	{
+		return input_latency_us_;
+	}
+	int GetPlayerCount() const
+	{
+		return int(players_.size());
+	}
+	const PlayerTelemetry& GetPlayer(int player_index) const
+	{
+		return players_[player_index];
+	}
+	// Totals over every player
+	std::uint64_t GetCatches() const;
+	std::uint64_t GetWrongCatches() const;
+	std::uint64_t GetMisses() const;
+
+	// The current summary, labelled with the session time, one line per measurement
+	std::string Summary(double session_time) const;
+private:
+	Histogram input_latency_us_;
+	std::pmr::vector<PlayerTelemetry> players_;
+};
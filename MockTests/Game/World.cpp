@@ -1,29 +1,235 @@
 #include "World.h"
 #include <iostream>
-#include <format>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <string_view>
 
-World::World(Location2D extent)
-	:
-	extent_(extent)
+class BoardTemplate
 {
-	for (int y = 0; y < extent_.y; y++)
+public:
+	BoardTemplate(Location2D extent)
 	{
-		for (int x = 0; x < extent_.x; x++)
+		for (int y = 0; y < extent.y; y++)
 		{
-			if (x == 0 || x == extent_.x - 1)
-				content_.append("|");
-			else if (y == extent_.y - 1)
-				content_.append("-");
-			else
-				content_.append(" ");
+			for (int x = 0; x < extent.x; x++)
+			{
+				if (x == 0 || x == extent.x - 1)
+					content_.append("|");
+				else if (y == extent.y - 1)
+					content_.append("-");
+				else
+					content_.append(" ");
+			}
 		}
 	}
+
+	// Returns the template shared by every live world of this extent, building it on first use
+	static std::shared_ptr<const BoardTemplate> Get(Location2D extent)
+	{
+		Cache& cache = GetCache();
+		std::lock_guard lock(cache.mutex_);
+
+		auto cached = cache.templates_.find({ extent.x, extent.y });
+		if (cached != cache.templates_.end())
+		{
+			if (std::shared_ptr<const BoardTemplate> board_template = cached->second.lock())
+				return board_template;
+		}
+
+		// Entries of extents no world uses anymore go before a new one is added, so the
+		// cache never holds more than the live extents
+		std::erase_if(cache.templates_, [](const auto& entry) { return entry.second.expired(); });
+
+		auto board_template = std::make_shared<const BoardTemplate>(extent);
+		cache.templates_[{ extent.x, extent.y }] = board_template;
+		return board_template;
+	}
+
+	static size_t GetCacheSize()
+	{
+		Cache& cache = GetCache();
+		std::lock_guard lock(cache.mutex_);
+
+		return cache.templates_.size();
+	}
+
+	const std::string& GetContent() const
+	{
+		return content_;
+	}
+private:
+	struct Cache
+	{
+		std::mutex mutex_;
+		std::map<std::pair<int, int>, std::weak_ptr<const BoardTemplate>> templates_;
+	};
+
+	static Cache& GetCache()
+	{
+		static Cache cache;
+		return cache;
+	}
+
+private:
+	std::string content_;
+};
+
+World::World(Location2D extent, std::pmr::memory_resource* resource)
+	:
+	extent_(extent),
+	board_template_(BoardTemplate::Get(extent)),
+	cells_(resource),
+	content_(resource),
+	changed_flags_(resource),
+	changed_cells_(resource),
+	draw_buffer_(resource)
+{
+}
+
+size_t World::GetTemplateCacheSize()
+{
+	return BoardTemplate::GetCacheSize();
 }
 
 void World::Draw() const
 {
-	for (int y = 0; y < extent_.y * extent_.x; y += extent_.x)
+	constexpr std::string_view indent = "    ";
+	const size_t row_size = indent.size() + size_t(extent_.x) + 1;
+
+	const std::string_view content = !content_.empty() ? std::string_view(content_) : std::string_view(board_template_->GetContent());
+
+	draw_buffer_.clear();
+	for (size_t y = 0; y < content.size(); y += extent_.x)
+	{
+		draw_buffer_.append(indent);
+		draw_buffer_.append(content.substr(y, extent_.x));
+		draw_buffer_.push_back('\n');
+	}
+
+	if (content_.empty())
+	{
+		for (const auto& cell : cells_)
+			draw_buffer_[size_t(cell.index_ / extent_.x) * row_size + indent.size() + size_t(cell.index_ % extent_.x)] = cell.value_;
+	}
+
+	std::cout.write(draw_buffer_.data(), std::streamsize(draw_buffer_.size()));
+}
+
+char World::GetCell(int index) const
+{
+	if (!content_.empty())
+		return content_[index];
+
+	auto cell = FindCell(index);
+	return cell != cells_.end() && cell->index_ == index ? cell->value_ : board_template_->GetContent()[index];
+}
+
+void World::SetCell(int index, char value)
+{
+	if (!changed_flags_.empty() && !changed_flags_[index])
+	{
+		changed_flags_[index] = 1;
+		if (content_.empty())
+			changed_cells_.push_back(index);
+	}
+
+	if (!content_.empty())
+	{
+		content_[index] = value;
+		return;
+	}
+
+	auto cell = FindCell(index);
+	const bool stored = cell != cells_.end() && cell->index_ == index;
+
+	if (value == board_template_->GetContent()[index])
+	{
+		if (stored)
+			cells_.erase(cell);
+	}
+	else if (stored)
+		cell->value_ = value;
+	else
+	{
+		cells_.insert(cell, Cell{ index, value });
+
+		// A busy board is cheaper as a full copy than as a list, whose inserts then grow linear
+		if (cells_.size() * sizeof(Cell) >= board_template_->GetContent().size())
+			MakeWritable();
+	}
+}
+
+void World::MakeWritable()
+{
+	if (!content_.empty())
+		return;
+
+	const std::string& content = board_template_->GetContent();
+	content_.assign(content.begin(), content.end());
+	for (const auto& cell : cells_)
+		content_[cell.index_] = cell.value_;
+
+	cells_.clear();
+	cells_.shrink_to_fit();
+}
+
+void World::TrackChanges()
+{
+	changed_flags_.assign(board_template_->GetContent().size(), 0);
+	changed_cells_.clear();
+}
+
+void World::TakeChangedCells(std::pmr::vector<int>& cells)
+{
+	if (content_.empty())
 	{
-		std::cout << std::format("    {}\n", content_.substr(y, size_t(extent_.x)));
+		for (int index : changed_cells_)
+			changed_flags_[index] = 0;
+		cells.insert(cells.end(), changed_cells_.begin(), changed_cells_.end());
 	}
+	else
+	{
+		for (int index = 0; index < int(changed_flags_.size()); index++)
+		{
+			if (changed_flags_[index])
+			{
+				changed_flags_[index] = 0;
+				cells.push_back(index);
+			}
+		}
+	}
+	changed_cells_.clear();
+}
+
+std::string World::GetContent() const
+{
+	if (!content_.empty())
+		return std::string(content_.begin(), content_.end());
+
+	std::string content = board_template_->GetContent();
+	for (const auto& cell : cells_)
+		content[cell.index_] = cell.value_;
+
+	return content;
+}
+
+int World::GetPrivateCellCount() const
+{
+	return !content_.empty() ? int(content_.size()) : int(cells_.size());
+}
+
+size_t World::GetPrivateBytes() const
+{
+	return !content_.empty() ? content_.capacity() : cells_.capacity() * sizeof(Cell);
+}
+
+std::pmr::vector<World::Cell>::iterator World::FindCell(int index)
+{
+	return std::lower_bound(cells_.begin(), cells_.end(), index, [](const Cell& cell, int i) { return cell.index_ < i; });
+}
+
+std::pmr::vector<World::Cell>::const_iterator World::FindCell(int index) const
+{
+	return std::lower_bound(cells_.begin(), cells_.end(), index, [](const Cell& cell, int i) { return cell.index_ < i; });
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
+#include <memory>
+#include <memory_resource>
 #include "Location2D.h"
 
 class IWorld
@@ -8,24 +12,70 @@ class IWorld
 public:
 	virtual void Draw() const = 0;
 	virtual Location2D GetExtent() const = 0;
-	virtual std::string& GetContentRef() = 0;
+	virtual char GetCell(int index) const = 0;
+	virtual void SetCell(int index, char value) = 0;
+	// Copies every shared part of the board up front, so SetCell can be called from several threads
+	virtual void MakeWritable() = 0;
+	// Starts collecting the indices of written cells
+	virtual void TrackChanges() = 0;
+	// Moves every cell written since the previous call into the vector, each one once
+	virtual void TakeChangedCells(std::pmr::vector<int>& cells) = 0;
 };
 
+class BoardTemplate;
+
+// The board starts as a view of an immutable template shared by every world of the same
+// extent. A world only keeps the cells that differ from the template, sorted by index, and
+// drops a cell again once it is written back to its template value, so a running game holds
+// just the player and the falling complements. MakeWritable switches to a full private copy
+// instead, which SetCell may then update from several threads; a world also switches by itself
+// once its list would take as much memory as that copy.
 class World : public IWorld
 {
 public:
-	World(Location2D extent);
+	// Private cells are allocated from the given resource
+	World(Location2D extent, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
 
 	void Draw() const override;
 	Location2D GetExtent() const override
 	{
 		return extent_;
 	}
-	std::string& GetContentRef() override
+	char GetCell(int index) const override;
+	void SetCell(int index, char value) override;
+	void MakeWritable() override;
+	void TrackChanges() override;
+	void TakeChangedCells(std::pmr::vector<int>& cells) override;
+
+	std::string GetContent() const;
+	// Cells the world stores itself rather than reading them from the template
+	int GetPrivateCellCount() const;
+	// Bytes allocated for those cells
+	size_t GetPrivateBytes() const;
+	// Extents with a cached template, which is at most one more than the extents of live worlds
+	static size_t GetTemplateCacheSize();
+private:
+	struct Cell
 	{
-		return content_;
-	}
+		int index_;
+		char value_;
+	};
+
+	std::pmr::vector<Cell>::iterator FindCell(int index);
+	std::pmr::vector<Cell>::const_iterator FindCell(int index) const;
+
 private:
 	Location2D extent_;
-	std::string content_;
-};
\ No newline at end of file
+	std::shared_ptr<const BoardTemplate> board_template_;
+	std::pmr::vector<Cell> cells_;
+	// Whole board, only filled once the world was made writable
+	std::pmr::string content_;
+	// One flag per cell while changes are tracked, plus the flagged cells in write order.
+	// Once writable only the flags are set, as SetCell may then run on several threads.
+	std::pmr::vector<std::uint8_t> changed_flags_;
+	std::pmr::vector<int> changed_cells_;
+	// Every frame is laid out here and printed at once, reusing the memory of the previous one
+	mutable std::pmr::string draw_buffer_;
+};
@@ -2,17 +2,36 @@
 #include <gmock/gmock.h>
 #include <memory>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <format>
+#include <functional>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
 #include "Game/Location2D.h"
 #include "Game/GameLoop.h"
 #include "Game/World.h"
 #include "Game/GameStatus.h"
 #include "Game/Player.h"
 #include "Game/ComplementsManager.h"
+#include "Game/Scheduler.h"
+#include "Game/Telemetry.h"
+#include "Game/ShardRuntime.h"
+#include "Game/BlockCompression.h"
+#include "Game/SessionRecording.h"
 
 class MockWorld : public IWorld {
 public:
     MOCK_METHOD(Location2D, GetExtent, (), (const, override));
-    MOCK_METHOD(std::string&, GetContentRef, (), (override));
+    MOCK_METHOD(char, GetCell, (int index), (const, override));
+    MOCK_METHOD(void, SetCell, (int index, char value), (override));
+    MOCK_METHOD(void, MakeWritable, (), (override));
+    MOCK_METHOD(void, TrackChanges, (), (override));
+    MOCK_METHOD(void, TakeChangedCells, (std::pmr::vector<int>& cells), (override));
     MOCK_METHOD(void, Draw, (), (const, override));
 };
 
@@ -23,6 +42,7 @@ public:
     MOCK_METHOD(void, AddToScoreLost, (int value), (override));
     MOCK_METHOD(void, PlayerLifesMinusOne, (), (override));
     MOCK_METHOD(bool, IsGameOver, (), (override));
+    MOCK_METHOD(StatusSnapshot, GetSnapshot, (), (const, override));
 };
 
 class MockPlayer : public IPlayer {
@@ -33,9 +53,66 @@ public:
     MOCK_METHOD(void, SetNumber, (int number), (override));
 };
 
+Task CountAfterDelay(Scheduler& scheduler, float seconds, int* counter)
+{
+    co_await scheduler.Delay(seconds);
+    ++*counter;
+}
+
+Task CountFrames(Scheduler& scheduler, int frames, int* counter)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        co_await scheduler.NextFrame();
+        ++*counter;
+    }
+}
+
+Task CountAfterCondition(Scheduler& scheduler, std::function<bool()> condition, float poll_interval, int* counter)
+{
+    co_await scheduler.WaitUntil(std::move(condition), poll_interval);
+    ++*counter;
+}
+
+Task CountNested(Scheduler& scheduler, int* counter)
+{
+    co_await CountFrames(scheduler, 2, counter);
+    co_await CountAfterDelay(scheduler, 1.0f, counter);
+    *counter *= 10;
+}
+
+// Logs every score change into a log shared by all players, preserving the global call order
+class RecordingGameStatus : public IGameStatus {
+public:
+    RecordingGameStatus(int id, std::vector<std::string>* log) : id_(id), log_(log) {}
+
+    void Draw() const override {}
+    void AddToScore(int value) override { log_->push_back(std::format("{} score {}", id_, value)); }
+    void AddToScoreLost(int value) override { log_->push_back(std::format("{} lost {}", id_, value)); }
+    void PlayerLifesMinusOne() override { log_->push_back(std::format("{} life", id_)); }
+    bool IsGameOver() override { return false; }
+    StatusSnapshot GetSnapshot() const override { return {}; }
+private:
+    int id_;
+    std::vector<std::string>* log_;
+};
+
 class MockComplementsManager : public IComplementsManager {
 public:
-    MOCK_METHOD(void, UpdateComplementsLifetime, (float dt), (override));
+    MOCK_METHOD(int, UpdateComplementsLifetime, (float dt), (override));
+    void AddEventListener(ScoreEventBuffer::Listener listener) override { score_events_.Subscribe(std::move(listener)); }
+
+    // Hands the events to the listeners as one tick, like the real manager ends an update
+    int Publish(std::vector<ScoreEvent> events)
+    {
+        score_events_.Clear();
+        for (const auto& event : events)
+            score_events_.Push(event);
+        score_events_.Publish();
+        return int(events.size());
+    }
+private:
+    ScoreEventBuffer score_events_;
 };
 
 TEST(TestPlayerWorldInteraction, PlayerWorldInteraction) 
@@ -48,12 +125,10 @@ TEST(TestPlayerWorldInteraction, PlayerWorldInteraction)
 
     // Setting default values to called methods
     ON_CALL(*world, GetExtent).WillByDefault(Return(Location2D{ 3, 3 }));
-    std::string default_value = "default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent());
-    EXPECT_CALL(*world, GetContentRef());
+    EXPECT_CALL(*world, SetCell(_, _)).Times(2);
 
     // Invoke the method being tested
     player->UpdateWorldLocation({ 1, 0 });
@@ -62,6 +137,137 @@ TEST(TestPlayerWorldInteraction, PlayerWorldInteraction)
     ASSERT_TRUE(player->GetLocation() == Location2D( 1, 1 ));
 }
 
+TEST(TestWorld, SessionsShareBoardTemplate)
+{
+    // Classes instantiation
+    std::unique_ptr<World> world_a = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<World> world_b = std::make_unique<World>(Location2D{ 17, 17 });
+
+    ASSERT_EQ(world_a->GetPrivateCellCount(), 0);
+    ASSERT_EQ(world_a->GetCell(0), '|');
+    ASSERT_EQ(world_a->GetCell(16 * 17 + 1), '-');
+
+    // Invoke the method being tested
+    world_a->SetCell(8 * 17 + 8, '5');
+
+    // Assertion
+    ASSERT_EQ(world_a->GetPrivateCellCount(), 1);
+    ASSERT_EQ(world_b->GetPrivateCellCount(), 0);
+    ASSERT_EQ(world_a->GetCell(8 * 17 + 8), '5');
+    ASSERT_EQ(world_b->GetCell(8 * 17 + 8), ' ');
+
+    std::string expected = world_b->GetContent();
+    expected[8 * 17 + 8] = '5';
+    ASSERT_EQ(world_a->GetContent(), expected);
+
+    // Writing the template value back shares the cell again
+    world_a->SetCell(8 * 17 + 8, ' ');
+    ASSERT_EQ(world_a->GetPrivateCellCount(), 0);
+    ASSERT_EQ(world_a->GetContent(), world_b->GetContent());
+}
+
+TEST(TestWorld, BusyBoardBecomesFullCopy)
+{
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::string expected = world->GetContent();
+
+    // Invoke the method being tested
+    for (int index = 18; index < 17 * 16; index += 2)
+    {
+        world->SetCell(index, '7');
+        expected[index] = '7';
+    }
+
+    // Assertion
+    ASSERT_EQ(world->GetPrivateCellCount(), 17 * 17);
+    ASSERT_EQ(world->GetContent(), expected);
+}
+
+TEST(TestWorld, TemplateCacheOnlyKeepsLiveExtents)
+{
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    const size_t cache_size = World::GetTemplateCacheSize();
+
+    // Invoke the method being tested
+    for (int i = 0; i < 1000; i++)
+        std::make_unique<World>(Location2D{ 20 + i, 20 });
+
+    // Assertion
+    ASSERT_LE(World::GetTemplateCacheSize(), cache_size + 1);
+    ASSERT_EQ(world->GetCell(0), '|');
+}
+
+TEST(TestWorld, DrawPrintsEveryRowIndented)
+{
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 5, 3 });
+    world->SetCell(1, '7');
+    world->SetCell(8, '3');
+
+    // Invoke the method being tested
+    testing::internal::CaptureStdout();
+    world->Draw();
+    world->MakeWritable();
+    world->Draw();
+    const std::string output = testing::internal::GetCapturedStdout();
+
+    // Assertion
+    const std::string frame = "    |7  |\n    |  3|\n    |---|\n";
+    ASSERT_EQ(output, frame + frame);
+}
+
+TEST(TestWorld, TracksChangedCells)
+{
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::pmr::vector<int> cells;
+
+    world->TrackChanges();
+    world->SetCell(40, '3');
+    world->SetCell(20, '4');
+    world->SetCell(40, ' ');
+
+    // Invoke the method being tested
+    world->TakeChangedCells(cells);
+    ASSERT_EQ(cells, std::pmr::vector<int>({ 40, 20 }));
+
+    cells.clear();
+    world->TakeChangedCells(cells);
+    ASSERT_TRUE(cells.empty());
+
+    // A writable board collects its changes by cell index
+    world->MakeWritable();
+    world->SetCell(60, '5');
+    world->SetCell(20, ' ');
+    world->TakeChangedCells(cells);
+    ASSERT_EQ(cells, std::pmr::vector<int>({ 20, 60 }));
+}
+
+TEST(TestWorld, RunningGameKeepsBoardShared)
+{
+    // Classes instantiation
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<GameStatus> game_status = std::make_unique<GameStatus>();
+    std::unique_ptr<Player> player = std::make_unique<Player>(Location2D{ 8, 15 }, world.get());
+    std::unique_ptr<ComplementsManager> comps_manager = std::make_unique<ComplementsManager>(world.get(), game_status.get(), player.get());
+
+    player->UpdateWorldLocation({ 0, 0 });
+
+    // Invoke the method being tested
+    for (int tick = 0; tick < 2000; tick++)
+    {
+        player->UpdateWorldLocation({ tick % 40 < 20 ? 1 : -1, 0 });
+        comps_manager->UpdateComplementsLifetime(0.1f);
+
+        // Only the player and the complements still falling differ from the template
+        ASSERT_LE(world->GetPrivateCellCount(), int(comps_manager->complements.size()) + 1);
+    }
+
+    // Assertion
+    ASSERT_LT(world->GetPrivateBytes(), world->GetContent().size() / 4);
+
+    world->MakeWritable();
+    ASSERT_EQ(world->GetPrivateCellCount(), 17 * 17);
+}
+
 TEST(TestGameLoop, GameLoopMemberCalls)
 {
     using namespace testing;
@@ -77,7 +283,7 @@ TEST(TestGameLoop, GameLoopMemberCalls)
     // Setting default values to called methods
     ON_CALL(*world, GetExtent).WillByDefault(Return(Location2D{ 3, 3 }));
     std::string default_value = "default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
     ON_CALL(*world, Draw).WillByDefault([]() {});
     
     int player_lifes = 3;
@@ -89,6 +295,7 @@ TEST(TestGameLoop, GameLoopMemberCalls)
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
+    ON_CALL(*comps_manager, UpdateComplementsLifetime).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*game_status, IsGameOver()).Times(5);
@@ -146,14 +353,14 @@ TEST(TestComplementsManager, PlayerGotScoreComplementRight)
 
     // Setting default values to called methods
     std::string default_value = "default value default value default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent());
-    EXPECT_CALL(*world, GetContentRef());
+    EXPECT_CALL(*world, GetCell(_));
     EXPECT_CALL(*game_status, AddToScore(9));
     EXPECT_CALL(*player, GetLocation());
     EXPECT_CALL(*player, GetNumber());
@@ -181,14 +388,14 @@ TEST(TestComplementsManager, PlayerGotScoreComplementWrong)
 
     // Setting default values to called methods
     std::string default_value = "default value default value default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent());
-    EXPECT_CALL(*world, GetContentRef());
+    EXPECT_CALL(*world, GetCell(_));
     EXPECT_CALL(*game_status, PlayerLifesMinusOne());
     EXPECT_CALL(*player, GetLocation());
     EXPECT_CALL(*player, GetNumber());
@@ -216,14 +423,14 @@ TEST(TestComplementsManager, PlayerMissedScore)
 
     // Setting default values to called methods
     std::string default_value = "default value default value default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent());
-    EXPECT_CALL(*world, GetContentRef());
+    EXPECT_CALL(*world, GetCell(_));
     EXPECT_CALL(*game_status, AddToScoreLost(9));
     EXPECT_CALL(*player, GetLocation());
 
@@ -234,6 +441,36 @@ TEST(TestComplementsManager, PlayerMissedScore)
     ASSERT_TRUE(comps_manager->complements.empty());
 }
 
+TEST(TestComplementsManager, PlayerOffBoardMissedScore)
+{
+    using namespace testing;
+
+    // Classes instantiation
+    std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+    std::shared_ptr<MockGameStatus> game_status = std::make_shared<MockGameStatus>();
+    std::shared_ptr<NiceMock<MockPlayer>> player = std::make_shared<NiceMock<MockPlayer>>();
+
+    ON_CALL(*world, GetExtent).WillByDefault(Return(Location2D{ 5, 3 }));
+
+    std::unique_ptr<ComplementsManager> comps_manager = std::make_unique<ComplementsManager>(world.get(), game_status.get(), player.get());
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 1 , 3 }, .number_ = 9, .time_since_last_update_ = 0.5f });
+
+    // Setting default values to called methods
+    std::string default_value = "default value default value default value";
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
+
+    ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(-1, -1)));
+
+    // Set expectations on mock methods
+    EXPECT_CALL(*game_status, AddToScoreLost(9));
+
+    // Invoke the method being tested
+    comps_manager->UpdateComplementsLifetime(0.1f);
+
+    // Assertion
+    ASSERT_TRUE(comps_manager->complements.empty());
+}
+
 TEST(TestComplementsManager, ScoreUpdateNoCatchNorMiss)
 {
     using namespace testing;
@@ -250,14 +487,14 @@ TEST(TestComplementsManager, ScoreUpdateNoCatchNorMiss)
 
     // Setting default values to called methods
     std::string default_value = "default value default value default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent());
-    EXPECT_CALL(*world, GetContentRef());
+    EXPECT_CALL(*world, GetCell(_));
     EXPECT_CALL(*player, GetLocation());
 
     // Invoke the method being tested
@@ -283,14 +520,14 @@ TEST(TestComplementsManager, ScoreNoNeedToUpdate)
 
     // Setting default values to called methods
     std::string default_value = "default value default value default value";
-    ON_CALL(*world, GetContentRef).WillByDefault(ReturnRef(default_value));
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
 
     ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
     ON_CALL(*player, GetNumber).WillByDefault(Return(1));
 
     // Set expectations on mock methods
     EXPECT_CALL(*world, GetExtent()).Times(0);
-    EXPECT_CALL(*world, GetContentRef()).Times(0);
+    EXPECT_CALL(*world, GetCell(_)).Times(0);
     EXPECT_CALL(*player, GetLocation()).Times(0);
 
     // Invoke the method being tested
@@ -300,6 +537,925 @@ TEST(TestComplementsManager, ScoreNoNeedToUpdate)
     ASSERT_FALSE(comps_manager->complements.empty());
 }
 
+TEST(TestGameLoop, GameOverCheckedOnlyAfterScoreEvents)
+{
+    using namespace testing;
+
+    // Classes instantiation
+    std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+    std::shared_ptr<NiceMock<MockGameStatus>> game_status = std::make_shared<NiceMock<MockGameStatus>>();
+    std::shared_ptr<NiceMock<MockPlayer>> player = std::make_shared<NiceMock<MockPlayer>>();
+    std::shared_ptr<MockComplementsManager> comps_manager = std::make_shared<MockComplementsManager>();
+
+    std::unique_ptr<GameLoop> GL = std::make_unique<GameLoop>(world, game_status, player, comps_manager);
+
+    // Setting default values to called methods
+    int frame = 0;
+    ON_CALL(*comps_manager, UpdateComplementsLifetime).WillByDefault(
+        [&frame](float)
+        {
+            return ++frame % 3 == 0 ? 1 : 0;
+        });
+    ON_CALL(*game_status, IsGameOver).WillByDefault(
+        [&frame]()
+        {
+            return frame >= 6;
+        });
+
+    // Set expectations on mock methods
+    EXPECT_CALL(*game_status, IsGameOver()).Times(3);
+    EXPECT_CALL(*comps_manager, UpdateComplementsLifetime).Times(6);
+
+    // Invoke the method being tested
+    GL->Run();
+}
+
+TEST(TestGameStatus, ApplyEventsBatch)
+{
+    std::unique_ptr<GameStatus> game_status = std::make_unique<GameStatus>();
+
+    std::vector<ScoreEvent> events = {
+        ScoreEvent{ 0, 0, ScoreEvent::Type::Score, 9 },
+        ScoreEvent{ 1, 0, ScoreEvent::Type::ScoreLost, 4 },
+        ScoreEvent{ 2, 0, ScoreEvent::Type::LifeLost, 1 } };
+
+    game_status->ApplyEvents(events);
+    ASSERT_FALSE(game_status->IsGameOver());
+
+    game_status->ApplyEvents(std::vector<ScoreEvent>{ ScoreEvent{ 3, 0, ScoreEvent::Type::ScoreLost, 6 } });
+    ASSERT_TRUE(game_status->IsGameOver());
+}
+
+TEST(TestComplementsManager, ScoreEventsPublishedOncePerTick)
+{
+    using namespace testing;
+
+    // Classes instantiation
+    std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+    std::shared_ptr<MockGameStatus> game_status = std::make_shared<MockGameStatus>();
+    std::shared_ptr<NiceMock<MockPlayer>> player = std::make_shared<NiceMock<MockPlayer>>();
+
+    ON_CALL(*world, GetExtent).WillByDefault(Return(Location2D{ 5, 3 }));
+
+    std::unique_ptr<ComplementsManager> comps_manager = std::make_unique<ComplementsManager>(world.get(), game_status.get(), player.get());
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 1 , 0 }, .number_ = 9, .time_since_last_update_ = 0.5f });
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 3 , 1 }, .number_ = 6, .time_since_last_update_ = 0.5f });
+
+    std::vector<std::vector<ScoreEvent>> batches;
+    comps_manager->AddEventListener([&batches](std::span<const ScoreEvent> events) { batches.emplace_back(events.begin(), events.end()); });
+
+    // Setting default values to called methods
+    std::string default_value = "default value default value default value";
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
+
+    ON_CALL(*player, GetLocation).WillByDefault(Return(Location2D(1, 1)));
+    ON_CALL(*player, GetNumber).WillByDefault(Return(1));
+
+    // Set expectations on mock methods
+    EXPECT_CALL(*game_status, AddToScore(9));
+    EXPECT_CALL(*game_status, AddToScoreLost(6));
+
+    // Invoke the method being tested
+    ASSERT_EQ(comps_manager->UpdateComplementsLifetime(0.1f), 2);
+    ASSERT_EQ(comps_manager->UpdateComplementsLifetime(0.1f), 0);
+
+    // Assertion
+    ASSERT_EQ(batches.size(), size_t(1));
+    ASSERT_EQ(batches[0].size(), size_t(2));
+    ASSERT_TRUE(batches[0][0].type_ == ScoreEvent::Type::Score);
+    ASSERT_TRUE(batches[0][1].type_ == ScoreEvent::Type::ScoreLost);
+}
+
+TEST(TestScheduler, DelayResumesAfterTimeout)
+{
+    Scheduler scheduler;
+    int counter = 0;
+
+    scheduler.Spawn(CountAfterDelay(scheduler, 0.5f, &counter));
+
+    scheduler.Tick(0.0f);
+    scheduler.Tick(0.3f);
+    ASSERT_EQ(counter, 0);
+
+    scheduler.Tick(0.3f);
+    ASSERT_EQ(counter, 1);
+    ASSERT_FALSE(scheduler.HasTasks());
+}
+
+TEST(TestScheduler, NestedTaskResumesCaller)
+{
+    Scheduler scheduler;
+    int counter = 0;
+
+    scheduler.Spawn(CountNested(scheduler, &counter));
+
+    for (int i = 0; i < 3; i++)
+        scheduler.Tick(0.0f);
+    ASSERT_EQ(counter, 2);
+
+    scheduler.Tick(1.0f);
+    ASSERT_EQ(counter, 30);
+    ASSERT_FALSE(scheduler.HasTasks());
+}
+
+TEST(TestScheduler, WaitUntilPollsOnlyAtItsInterval)
+{
+    Scheduler scheduler;
+    int counter = 0;
+    int polls = 0;
+    bool ready = false;
+
+    scheduler.Spawn(CountAfterCondition(scheduler, [&polls, &ready]() { ++polls; return ready; }, 0.5f, &counter));
+    scheduler.Tick(0.0f);
+
+    // An idle scheduler sleeps until the next poll instead of waking every frame
+    ASSERT_EQ(polls, 1);
+    ASSERT_DOUBLE_EQ(scheduler.TimeUntilNextWake(), 0.5);
+
+    for (int i = 0; i < 10; i++)
+        scheduler.Tick(0.1f);
+    ASSERT_EQ(polls, 3);
+
+    ready = true;
+    for (int i = 0; i < 5; i++)
+        scheduler.Tick(0.1f);
+
+    // Assertion
+    ASSERT_EQ(polls, 4);
+    ASSERT_EQ(counter, 1);
+    ASSERT_FALSE(scheduler.HasTasks());
+}
+
+TEST(TestScheduler, FramesComeFromFrameResource)
+{
+    std::unique_ptr<ShardArena> arena = std::make_unique<ShardArena>(0, 4096);
+    int counter = 0;
+
+    {
+        Scheduler scheduler(arena.get());
+        scheduler.Spawn(CountNested(scheduler, &counter));
+
+        for (int i = 0; i < 4; i++)
+            scheduler.Tick(1.0f);
+        ASSERT_FALSE(scheduler.HasTasks());
+    }
+
+    // Assertion
+    ASSERT_EQ(counter, 30);
+    ASSERT_EQ(arena->GetAllocations(), std::uint64_t(3));
+}
+
+TEST(TestGameLoop, SessionsShareOneScheduler)
+{
+    using namespace testing;
+
+    constexpr int sessions_count = 100;
+
+    Scheduler scheduler;
+    std::vector<std::unique_ptr<GameLoop>> sessions;
+    std::vector<int> frames(sessions_count, 0);
+
+    for (int i = 0; i < sessions_count; i++)
+    {
+        // Classes instantiation
+        std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+        std::shared_ptr<NiceMock<MockGameStatus>> game_status = std::make_shared<NiceMock<MockGameStatus>>();
+        std::shared_ptr<NiceMock<MockPlayer>> player = std::make_shared<NiceMock<MockPlayer>>();
+        std::shared_ptr<NiceMock<MockComplementsManager>> comps_manager = std::make_shared<NiceMock<MockComplementsManager>>();
+
+        // Session i ends after i % 5 + 1 frames
+        int* session_frames = &frames[i];
+        ON_CALL(*comps_manager, UpdateComplementsLifetime).WillByDefault(
+            [session_frames](float)
+            {
+                ++*session_frames;
+                return 1;
+            });
+        ON_CALL(*game_status, IsGameOver).WillByDefault(
+            [session_frames, i]()
+            {
+                return *session_frames >= i % 5 + 1;
+            });
+
+        sessions.push_back(std::make_unique<GameLoop>(world, game_status, player, comps_manager));
+        scheduler.Spawn(sessions.back()->Session(scheduler));
+    }
+
+    // Invoke the method being tested
+    int ticks = 0;
+    while (scheduler.HasTasks() && ticks < 100)
+    {
+        scheduler.Tick(1.0f / 60.0f);
+        ticks++;
+    }
+
+    // Assertion
+    ASSERT_FALSE(scheduler.HasTasks());
+    for (int i = 0; i < sessions_count; i++)
+    {
+        ASSERT_EQ(frames[i], i % 5 + 1);
+    }
+}
+
+TEST(TestTelemetry, HistogramPercentiles)
+{
+    std::unique_ptr<Histogram> histogram = std::make_unique<Histogram>();
+
+    for (std::uint64_t value = 1; value <= 10000; value++)
+        histogram->Record(value);
+
+    // Assertion
+    ASSERT_EQ(histogram->GetCount(), std::uint64_t(10000));
+    ASSERT_EQ(histogram->GetMax(), std::uint64_t(10000));
+    ASSERT_NEAR(double(histogram->ValueAtPercentile(50.0)), 5000.0, 5000.0 * 0.04);
+    ASSERT_NEAR(double(histogram->ValueAtPercentile(99.0)), 9900.0, 9900.0 * 0.04);
+    ASSERT_EQ(histogram->ValueAtPercentile(100.0), std::uint64_t(10000));
+
+    histogram->Reset();
+    ASSERT_EQ(histogram->ValueAtPercentile(50.0), std::uint64_t(0));
+}
+
+TEST(TestTelemetry, ScoreEventsExportedAsSummary)
+{
+    using namespace std::chrono_literals;
+
+    std::unique_ptr<Telemetry> telemetry = std::make_unique<Telemetry>();
+
+    std::vector<ScoreEvent> events = {
+        ScoreEvent{ 0, 0, ScoreEvent::Type::Score, 9, 1.5f },
+        ScoreEvent{ 1, 0, ScoreEvent::Type::Score, 4, 2.0f },
+        ScoreEvent{ 2, 0, ScoreEvent::Type::LifeLost, 1, 1.0f },
+        ScoreEvent{ 3, 0, ScoreEvent::Type::ScoreLost, 6, 8.0f } };
+
+    telemetry->RecordScoreEvents(events);
+    telemetry->RecordInputLatency(16ms);
+
+    // Assertion
+    ASSERT_EQ(telemetry->GetCatches(), std::uint64_t(2));
+    ASSERT_EQ(telemetry->GetWrongCatches(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetMisses(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetPlayer(0).GetTimeOnBoard().GetMax(), std::uint64_t(8000));
+    ASSERT_NEAR(double(telemetry->GetInputLatency().ValueAtPercentile(50.0)), 16000.0, 16000.0 * 0.04);
+
+    const std::string path = "telemetry_test_summary.txt";
+    std::remove(path.c_str());
+    std::unique_ptr<RecordingWriter> writer = std::make_unique<RecordingWriter>();
+    writer->AppendToFile(path, telemetry->Summary(5.0));
+    writer->Flush();
+
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    file.close();
+    std::remove(path.c_str());
+
+    ASSERT_NE(content.str().find("catch_rate=0.500"), std::string::npos);
+    ASSERT_NE(content.str().find("time_on_board_ms count=4"), std::string::npos);
+}
+
+TEST(TestTelemetry, ScoreEventsKeptPerPlayer)
+{
+    std::unique_ptr<Telemetry> telemetry = std::make_unique<Telemetry>(3);
+
+    std::vector<ScoreEvent> events = {
+        ScoreEvent{ 0, 0, ScoreEvent::Type::Score, 9, 1.0f },
+        ScoreEvent{ 1, 2, ScoreEvent::Type::Score, 4, 3.0f },
+        ScoreEvent{ 2, 2, ScoreEvent::Type::ScoreLost, 6, 5.0f },
+        ScoreEvent{ 3, 2, ScoreEvent::Type::LifeLost, 1, 2.0f },
+        ScoreEvent{ 4, 7, ScoreEvent::Type::Score, 1, 2.0f } };
+
+    // Invoke the method being tested
+    telemetry->RecordScoreEvents(events);
+
+    // Assertion
+    ASSERT_EQ(telemetry->GetPlayer(0).GetCatches(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetPlayer(0).GetTimeOnBoard().GetMax(), std::uint64_t(1000));
+    ASSERT_EQ(telemetry->GetPlayer(1).GetTimeOnBoard().GetCount(), std::uint64_t(0));
+    ASSERT_EQ(telemetry->GetPlayer(2).GetCatches(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetPlayer(2).GetMisses(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetPlayer(2).GetWrongCatches(), std::uint64_t(1));
+    ASSERT_EQ(telemetry->GetPlayer(2).GetTimeOnBoard().GetMax(), std::uint64_t(5000));
+    ASSERT_EQ(telemetry->GetCatches(), std::uint64_t(2));
+    ASSERT_NE(telemetry->Summary(1.0).find("player 2 catches=1 wrong_catches=1 misses=1"), std::string::npos);
+}
+
+TEST(TestGameLoop, TelemetryFromInjectedSession)
+{
+    using namespace testing;
+
+    // Classes instantiation
+    std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+    std::shared_ptr<NiceMock<MockGameStatus>> game_status = std::make_shared<NiceMock<MockGameStatus>>();
+    std::shared_ptr<NiceMock<MockPlayer>> player = std::make_shared<NiceMock<MockPlayer>>();
+    std::shared_ptr<NiceMock<MockComplementsManager>> comps_manager = std::make_shared<NiceMock<MockComplementsManager>>();
+
+    std::unique_ptr<GameLoop> GL = std::make_unique<GameLoop>(world, game_status, player, comps_manager);
+
+    // Setting default values to called methods
+    int frame = 0;
+    ON_CALL(*comps_manager, UpdateComplementsLifetime).WillByDefault(
+        [&frame, comps_manager = comps_manager.get()](float)
+        {
+            ++frame;
+            return comps_manager->Publish({ ScoreEvent{ frame, 0, ScoreEvent::Type::Score, 9, 0.5f } });
+        });
+    ON_CALL(*game_status, IsGameOver).WillByDefault(
+        [&frame]()
+        {
+            return frame >= 4;
+        });
+
+    // The player moves on the first two frames only, each shown by the following frame's draw
+    GL->SetKeyState([&frame](int key) { return key == 'D' && frame < 2; });
+
+    // Invoke the method being tested
+    GL->Run();
+
+    // Assertion
+    ASSERT_EQ(GL->GetTelemetry().GetCatches(), std::uint64_t(4));
+    ASSERT_EQ(GL->GetTelemetry().GetPlayer(0).GetTimeOnBoard().GetCount(), std::uint64_t(4));
+    ASSERT_EQ(GL->GetTelemetry().GetInputLatency().GetCount(), std::uint64_t(2));
+}
+
+TEST(TestShardRuntime, SessionsRunInShardArenas)
+{
+    using namespace testing;
+
+    constexpr int sessions_count = 10;
+
+    std::unique_ptr<ShardRuntime> runtime = std::make_unique<ShardRuntime>(2);
+
+    for (int i = 0; i < sessions_count; i++)
+    {
+        runtime->StartSession([](std::pmr::polymorphic_allocator<> allocator)
+            {
+                // Classes instantiation
+                auto world = std::allocate_shared<NiceMock<MockWorld>>(std::pmr::polymorphic_allocator<NiceMock<MockWorld>>(allocator));
+                auto game_status = std::allocate_shared<NiceMock<MockGameStatus>>(std::pmr::polymorphic_allocator<NiceMock<MockGameStatus>>(allocator));
+                auto player = std::allocate_shared<NiceMock<MockPlayer>>(std::pmr::polymorphic_allocator<NiceMock<MockPlayer>>(allocator));
+                auto comps_manager = std::allocate_shared<NiceMock<MockComplementsManager>>(std::pmr::polymorphic_allocator<NiceMock<MockComplementsManager>>(allocator));
+
+                // Setting default values to called methods
+                ON_CALL(*game_status, IsGameOver).WillByDefault(Return(true));
+
+                return allocator.new_object<GameLoop>(world, game_status, player, comps_manager);
+            });
+    }
+
+    // Invoke the method being tested
+    runtime->Shutdown();
+
+    // Assertion
+    std::vector<ShardRuntime::ShardStats> stats = runtime->GetStats();
+    ASSERT_EQ(stats.size(), size_t(2));
+    for (const auto& shard : stats)
+    {
+        ASSERT_EQ(shard.sessions_started_, std::uint64_t(sessions_count / 2));
+        // The session and its four parts, plus the RunSession, Session and Play frames
+        ASSERT_GE(shard.allocations_, std::uint64_t(sessions_count / 2 * 8));
+        ASSERT_EQ(shard.cross_shard_allocations_, std::uint64_t(0));
+    }
+}
+
+TEST(TestShardRuntime, ArenaCountsCrossShardAllocations)
+{
+    std::unique_ptr<ShardArena> arena = std::make_unique<ShardArena>(3, 4096);
+
+    // The test thread is no shard worker, so everything it allocates here is cross shard
+    std::pmr::vector<int> values(arena.get());
+    values.resize(100);
+
+    // Assertion
+    ASSERT_EQ(arena->GetAllocations(), std::uint64_t(1));
+    ASSERT_EQ(arena->GetCrossShardAllocations(), std::uint64_t(1));
+    ASSERT_GE(arena->GetBytesAllocated(), 100 * sizeof(int));
+}
+
+TEST(TestShardRuntime, ArenaReusesMemoryOfFinishedSessions)
+{
+    constexpr int warm_up_sessions = 100;
+    constexpr int sessions_count = 5000;
+
+    std::unique_ptr<ShardArena> arena = std::make_unique<ShardArena>(0, 1 << 16);
+    std::pmr::polymorphic_allocator<> allocator(arena.get());
+
+    auto run_sessions = [&allocator](int count)
+    {
+        for (int i = 0; i < count; i++)
+            allocator.delete_object(allocator.new_object<GameLoop>(allocator.resource()));
+    };
+
+    // Invoke the method being tested
+    run_sessions(warm_up_sessions);
+    const std::uint64_t reserved = arena->GetReservedBytes();
+    run_sessions(sessions_count);
+
+    // Assertion
+    ASSERT_GT(reserved, sizeof(GameLoop));
+    ASSERT_EQ(arena->GetReservedBytes(), reserved);
+}
+
+TEST(TestSessionRecording, BlockCompressionRoundTrip)
+{
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    const std::string board = world->GetContent();
+
+    std::vector<std::uint8_t> input(board.begin(), board.end());
+    std::vector<std::uint8_t> output;
+
+    std::vector<std::uint8_t> compressed = CompressBlock(input);
+    ASSERT_LT(compressed.size(), input.size() / 4);
+    ASSERT_TRUE(DecompressBlock(compressed, input.size(), output));
+    ASSERT_EQ(output, input);
+
+    std::mt19937 rnd_gen(7);
+    std::vector<std::uint8_t> noise(5000);
+    for (auto& byte : noise)
+        byte = std::uint8_t(rnd_gen());
+
+    ASSERT_TRUE(DecompressBlock(CompressBlock(noise), noise.size(), output));
+    ASSERT_EQ(output, noise);
+    ASSERT_FALSE(DecompressBlock(compressed, input.size() + 1, output));
+}
+
+TEST(TestSessionRecording, SeekRebuildsAnyTick)
+{
+    constexpr int ticks_count = 100;
+    const std::string path = "session_recording_test.rec";
+
+    // Classes instantiation
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<RecordingWriter> writer = std::make_unique<RecordingWriter>();
+    GameStatus status;
+
+    std::vector<std::string> boards = { world->GetContent() };
+    std::vector<int> scores = { status.GetScore() };
+    std::vector<int> lifes = { status.GetPlayerLifes() };
+
+    {
+        SessionRecorder recorder(path, *world, status, 16, *writer);
+
+        for (int tick = 1; tick <= ticks_count; tick++)
+        {
+            world->SetCell((tick * 7) % (17 * 16), char('0' + tick % 10));
+
+            std::vector<ScoreEvent> events = { ScoreEvent{ tick, 0, ScoreEvent::Type::Score, tick % 9 + 1 } };
+            if (tick % 25 == 0)
+                events.push_back(ScoreEvent{ tick, 0, ScoreEvent::Type::LifeLost, 1 });
+            recorder.AddEvents(events);
+            status.ApplyEvents(events);
+
+            recorder.RecordTick();
+
+            boards.push_back(world->GetContent());
+            scores.push_back(status.GetScore());
+            lifes.push_back(status.GetPlayerLifes());
+        }
+    }
+    writer->Flush();
+
+    SessionReader reader(path);
+
+    // Assertion
+    ASSERT_TRUE(reader.IsOpen());
+    ASSERT_EQ(reader.GetTickCount(), std::uint64_t(ticks_count));
+    ASSERT_TRUE(reader.GetExtent() == Location2D(17, 17));
+
+    for (int tick : { 73, 0, 1, 15, 16, 17, 50, 100, 32 })
+    {
+        ASSERT_TRUE(reader.SeekToTick(tick));
+        ASSERT_EQ(reader.GetBoard(), boards[tick]);
+        ASSERT_EQ(reader.GetStatus().GetScore(), scores[tick]);
+        ASSERT_EQ(reader.GetStatus().GetPlayerLifes(), lifes[tick]);
+    }
+    ASSERT_FALSE(reader.SeekToTick(ticks_count + 1));
+
+    std::remove(path.c_str());
+}
+
+TEST(TestSessionRecording, SmallQueueStillRecordsEverything)
+{
+    constexpr int ticks_count = 200;
+    const std::string path = "bounded_recording_test.rec";
+
+    // Classes instantiation
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<RecordingWriter> writer = std::make_unique<RecordingWriter>(64);
+    GameStatus status;
+
+    // Invoke the method being tested, every chunk being larger than the whole queue
+    {
+        SessionRecorder recorder(path, *world, status, 4, *writer);
+        for (int tick = 1; tick <= ticks_count; tick++)
+        {
+            world->SetCell(tick % (17 * 16), char('0' + tick % 10));
+            recorder.RecordTick();
+        }
+    }
+    writer->Flush();
+
+    SessionReader reader(path);
+
+    // Assertion
+    ASSERT_TRUE(reader.IsOpen());
+    ASSERT_EQ(reader.GetTickCount(), std::uint64_t(ticks_count));
+    ASSERT_TRUE(reader.SeekToTick(ticks_count));
+    ASSERT_EQ(reader.GetBoard(), world->GetContent());
+
+    std::remove(path.c_str());
+}
+
+TEST(TestSessionRecording, ReportsFilesItCannotWrite)
+{
+    const std::string path = "missing_directory/recording_test.rec";
+
+    // Classes instantiation
+    std::vector<std::string> errors;
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<RecordingWriter> writer = std::make_unique<RecordingWriter>(RecordingWriter::DEFAULT_MAX_QUEUED_BYTES,
+        [&errors](const std::string& failed_path, const std::string&) { errors.push_back(failed_path); });
+    GameStatus status;
+
+    // Invoke the method being tested
+    {
+        SessionRecorder recorder(path, *world, status, 4, *writer);
+        for (int tick = 1; tick <= 10; tick++)
+            recorder.RecordTick();
+    }
+    writer->Flush();
+
+    writer->AppendToFile("missing_directory/summary.txt", "summary");
+    writer->Flush();
+
+    // Assertion
+    ASSERT_EQ(errors, (std::vector<std::string>{ path, "missing_directory/summary.txt" }));
+    ASSERT_FALSE(SessionReader(path).IsOpen());
+}
+
+TEST(TestSessionRecording, RejectsTruncatedAndCorruptFiles)
+{
+    const std::string path = "corrupt_recording_test.rec";
+
+    std::unique_ptr<World> world = std::make_unique<World>(Location2D{ 17, 17 });
+    std::unique_ptr<RecordingWriter> writer = std::make_unique<RecordingWriter>();
+    GameStatus status;
+    {
+        SessionRecorder recorder(path, *world, status, 8, *writer);
+        for (int tick = 1; tick <= 40; tick++)
+        {
+            world->SetCell(tick, 'x');
+            recorder.RecordTick();
+        }
+    }
+    writer->Flush();
+
+    std::string original;
+    {
+        std::ifstream file(path, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_TRUE(SessionReader(path).IsOpen());
+
+    // Opens the bytes as a recording and seeks every tick, which must fail cleanly rather than crash
+    auto read_all = [&path](const std::string& bytes) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), std::streamsize(bytes.size()));
+        SessionReader reader(path);
+        bool all_sought = reader.IsOpen();
+        for (std::uint64_t tick = 0; tick <= 40; tick++)
+            all_sought = reader.SeekToTick(tick) && all_sought;
+        return std::make_pair(reader.IsOpen(), all_sought);
+    };
+    auto patch = [&original](std::size_t offset, std::uint64_t value, std::size_t size) {
+        std::string bytes = original;
+        std::memcpy(bytes.data() + offset, &value, size);
+        return bytes;
+    };
+    const std::size_t trailer = original.size() - 24;
+
+    // Assertion
+    ASSERT_EQ(read_all(original), std::make_pair(true, true));
+    for (std::size_t size : { std::size_t(0), std::size_t(10), std::size_t(30), original.size() / 2, original.size() - 1 })
+        ASSERT_FALSE(read_all(original.substr(0, size)).first);
+
+    // Chunk count far past the file, and one more chunk than there are
+    ASSERT_FALSE(read_all(patch(trailer + 8, std::uint64_t(1) << 60, 8)).first);
+    ASSERT_FALSE(read_all(patch(trailer + 8, 6, 8)).first);
+    // First chunk offset into the index, and chunk offsets out of order
+    ASSERT_FALSE(read_all(patch(trailer - 5 * 16 + 8, trailer, 8)).first);
+    ASSERT_FALSE(read_all(patch(trailer - 4 * 16 + 8, 16, 8)).first);
+    // Frame sizes larger than the file
+    ASSERT_FALSE(read_all(patch(16, 0xFFFFFFFF, 4)).second);
+    ASSERT_FALSE(read_all(patch(20, 0xFFFFFFFF, 4)).second);
+    ASSERT_FALSE(read_all(patch(20, 1, 4)).second);
+
+    std::remove(path.c_str());
+}
+
+TEST(TestSessionRecording, RecorderAllocatesFromSessionResource)
+{
+    const std::string path = "arena_recording_test.rec";
+
+    // Classes instantiation
+    std::unique_ptr<ShardArena> arena = std::make_unique<ShardArena>(0, 1 << 16);
+    std::unique_ptr<GameLoop> GL = std::make_unique<GameLoop>(arena.get());
+    GL->SetRecording(path);
+    GL->SetTelemetryExport("arena_telemetry_test.txt", 1000.0f);
+    GL->SetKeyState([](int) { return false; });
+
+    // Invoke the method being tested, with nothing left to fall back to the default resource
+    Scheduler scheduler(arena.get());
+    std::pmr::memory_resource* default_resource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    scheduler.Spawn(GL->Play(scheduler));
+    for (int tick = 0; tick < 10 && scheduler.HasTasks(); tick++)
+        scheduler.Tick(1.0f);
+    std::pmr::set_default_resource(default_resource);
+
+    // Assertion
+    ASSERT_GT(arena->GetAllocations(), std::uint64_t(0));
+
+    GL.reset();
+    RecordingWriter::GetShared().Flush();
+    ASSERT_TRUE(SessionReader(path).IsOpen());
+    std::remove(path.c_str());
+    std::remove("arena_telemetry_test.txt");
+}
+
+TEST(TestSessionRecording, GameLoopRecordsPlay)
+{
+    const std::string path = "game_loop_recording_test.rec";
+
+    // Classes instantiation
+    std::shared_ptr<World> world = std::make_shared<World>(Location2D{ 17, 17 });
+    std::shared_ptr<GameStatus> game_status = std::make_shared<GameStatus>();
+    std::shared_ptr<Player> player = std::make_shared<Player>(Location2D{ 8, 15 }, world.get());
+    std::shared_ptr<ComplementsManager> comps_manager = std::make_shared<ComplementsManager>(world.get(), game_status.get(), player.get());
+
+    std::unique_ptr<GameLoop> GL = std::make_unique<GameLoop>(world, game_status, player, comps_manager);
+    GL->SetRecording(path);
+    GL->SetKeyState([](int) { return false; });
+
+    // Invoke the method being tested, one second per frame until the missed complements end the game
+    Scheduler scheduler;
+    scheduler.Spawn(GL->Play(scheduler));
+    int ticks = 0;
+    while (scheduler.HasTasks() && ticks < 1000)
+    {
+        scheduler.Tick(1.0f);
+        ticks++;
+    }
+    RecordingWriter::GetShared().Flush();
+
+    SessionReader reader(path);
+
+    // Assertion
+    ASSERT_FALSE(scheduler.HasTasks());
+    ASSERT_TRUE(game_status->IsGameOver());
+    ASSERT_TRUE(reader.IsOpen());
+    ASSERT_GT(reader.GetTickCount(), std::uint64_t(0));
+
+    ASSERT_TRUE(reader.SeekToTick(reader.GetTickCount()));
+    ASSERT_EQ(reader.GetBoard(), world->GetContent());
+    ASSERT_EQ(reader.GetStatus().GetScore(), game_status->GetScore());
+    ASSERT_EQ(reader.GetStatus().GetScoreLost(), game_status->GetScoreLost());
+    ASSERT_EQ(reader.GetStatus().GetPlayerLifes(), game_status->GetPlayerLifes());
+
+    ASSERT_TRUE(reader.SeekToTick(0));
+    ASSERT_EQ(reader.GetStatus().GetScoreLost(), 0);
+
+    std::remove(path.c_str());
+}
+
+TEST(TestComplementsManager, MultiPlayerScoreRouting)
+{
+    using namespace testing;
+
+    // Classes instantiation
+    std::shared_ptr<NiceMock<MockWorld>> world = std::make_shared<NiceMock<MockWorld>>();
+    std::shared_ptr<MockGameStatus> game_status_a = std::make_shared<MockGameStatus>();
+    std::shared_ptr<MockGameStatus> game_status_b = std::make_shared<MockGameStatus>();
+    std::shared_ptr<NiceMock<MockPlayer>> player_a = std::make_shared<NiceMock<MockPlayer>>();
+    std::shared_ptr<NiceMock<MockPlayer>> player_b = std::make_shared<NiceMock<MockPlayer>>();
+
+    ON_CALL(*world, GetExtent).WillByDefault(Return(Location2D{ 5, 3 }));
+
+    std::unique_ptr<ComplementsManager> comps_manager = std::make_unique<ComplementsManager>(world.get(),
+        std::vector<IGameStatus*>{ game_status_a.get(), game_status_b.get() }, std::vector<IPlayer*>{ player_a.get(), player_b.get() });
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 3 , 0 }, .number_ = 9, .time_since_last_update_ = 0.5f });
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 4 , 1 }, .number_ = 7, .time_since_last_update_ = 0.5f });
+    comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { 2 , 1 }, .number_ = 5, .time_since_last_update_ = 0.5f });
+
+    // Setting default values to called methods
+    std::string default_value = "default value default value default value";
+    ON_CALL(*world, GetCell).WillByDefault([&default_value](int index) { return default_value[index]; });
+
+    ON_CALL(*player_a, GetLocation).WillByDefault(Return(Location2D(1, 1)));
+    ON_CALL(*player_a, GetNumber).WillByDefault(Return(2));
+    ON_CALL(*player_b, GetLocation).WillByDefault(Return(Location2D(3, 1)));
+    ON_CALL(*player_b, GetNumber).WillByDefault(Return(1));
+
+    // Set expectations on mock methods
+    EXPECT_CALL(*world, GetExtent());
+    EXPECT_CALL(*world, GetCell(_)).Times(3);
+    EXPECT_CALL(*player_a, GetLocation());
+    EXPECT_CALL(*player_b, GetLocation());
+    EXPECT_CALL(*player_a, GetNumber()).Times(0);
+    EXPECT_CALL(*game_status_b, AddToScore(9));
+    EXPECT_CALL(*game_status_b, AddToScoreLost(7));
+    EXPECT_CALL(*game_status_a, AddToScoreLost(5));
+
+    // Invoke the method being tested
+    comps_manager->UpdateComplementsLifetime(0.1f);
+
+    // Assertion
+    ASSERT_TRUE(comps_manager->complements.empty());
+}
+
+// A world with a player on every player_step-th column just above the floor, and
+// complement_rows rows of complements over every playable column
+template<typename Status>
+struct CrowdedBoard
+{
+    CrowdedBoard(int players_count, int player_step, int complement_rows, std::function<std::unique_ptr<Status>(int)> make_status)
+        :
+        columns(players_count * player_step + 2),
+        world(std::make_unique<World>(Location2D{ columns, complement_rows + 2 }))
+    {
+        std::vector<IGameStatus*> game_status_ptrs;
+        std::vector<IPlayer*> player_ptrs;
+
+        for (int i = 0; i < players_count; i++)
+        {
+            game_statuses.push_back(make_status(i));
+            players.push_back(std::make_unique<Player>(Location2D{ i * player_step + 1, complement_rows }, world.get()));
+            players.back()->SetNumber(i % 9 + 1);
+            game_status_ptrs.push_back(game_statuses.back().get());
+            player_ptrs.push_back(players.back().get());
+        }
+
+        comps_manager = std::make_unique<ComplementsManager>(world.get(), game_status_ptrs, player_ptrs);
+
+        for (int i = 0; i < (columns - 2) * complement_rows; i++)
+        {
+            comps_manager->complements.push_back(ComplementsManager::Complement{ .loc_ = { i % (columns - 2) + 1, i / (columns - 2) }, .number_ = char(i % 7 + 1), .time_since_last_update_ = 0.0f });
+        }
+    }
+
+    int columns;
+    std::unique_ptr<World> world;
+    std::vector<std::unique_ptr<Status>> game_statuses;
+    std::vector<std::unique_ptr<Player>> players;
+    std::unique_ptr<ComplementsManager> comps_manager;
+};
+
+TEST(TestComplementsManager, MultiPlayerLargeBoard)
+{
+    constexpr int players_count = 250;
+    constexpr int player_step = 4;
+    constexpr int complement_rows = 100;
+
+    for (int workers : { 1, 4 })
+    {
+        // Classes instantiation
+        CrowdedBoard<GameStatus> board(players_count, player_step, complement_rows, [](int) { return std::make_unique<GameStatus>(); });
+        board.comps_manager->SetWorkerCount(workers);
+
+        // A complement lands on the player of its column, or else is missed by the nearest
+        // player, the left one on a tie and the last one past the rightmost player
+        std::vector<int> expected_scores(players_count, 0);
+        std::vector<int> expected_lost(players_count, 0);
+        std::vector<int> expected_lifes(players_count, 3);
+        for (const auto& complement : board.comps_manager->complements)
+        {
+            const int left = (complement.loc_.x - 1) / player_step;
+            const int left_distance = (complement.loc_.x - 1) % player_step;
+
+            if (left_distance == 0)
+            {
+                if (complement.number_ + board.players[left]->GetNumber() == 10)
+                    expected_scores[left] += complement.number_;
+                else
+                    expected_lifes[left]--;
+            }
+            else
+            {
+                const bool to_right = left + 1 < players_count && player_step - left_distance < left_distance;
+                expected_lost[to_right ? left + 1 : left] += complement.number_;
+            }
+        }
+
+        // Invoke the method being tested
+        for (int tick = 0; tick <= complement_rows; tick++)
+        {
+            board.comps_manager->UpdateComplementsLifetime(0.6f);
+        }
+
+        // Assertion
+        for (int i = 0; i < players_count; i++)
+        {
+            ASSERT_EQ(board.game_statuses[i]->GetScore(), expected_scores[i]);
+            ASSERT_EQ(board.game_statuses[i]->GetScoreLost(), expected_lost[i]);
+            ASSERT_EQ(board.game_statuses[i]->GetPlayerLifes(), expected_lifes[i]);
+        }
+        // Only complements spawned during the run are left, none of them fell far enough to land yet
+        for (const auto& complement : board.comps_manager->complements)
+        {
+            ASSERT_LT(complement.loc_.y, complement_rows);
+        }
+    }
+}
+
+TEST(TestComplementsManager, ParallelUpdateMatchesSerial)
+{
+    constexpr int players_count = 500;
+    constexpr int complement_rows = 100;
+
+    // Players stand on every other column so both catches and misses happen
+    std::vector<std::string> serial_log;
+    std::vector<std::string> parallel_log;
+    CrowdedBoard<RecordingGameStatus> serial(players_count, 2, complement_rows, [&serial_log](int i) { return std::make_unique<RecordingGameStatus>(i, &serial_log); });
+    CrowdedBoard<RecordingGameStatus> parallel(players_count, 2, complement_rows, [&parallel_log](int i) { return std::make_unique<RecordingGameStatus>(i, &parallel_log); });
+    parallel.comps_manager->SetWorkerCount(4);
+
+    // Four ticks stay under the spawn rate, so no random complement joins either board
+    for (int tick = 0; tick < 4; tick++)
+    {
+        serial.comps_manager->UpdateComplementsLifetime(0.6f);
+        parallel.comps_manager->UpdateComplementsLifetime(0.6f);
+    }
+
+    // Assertion
+    ASSERT_FALSE(serial_log.empty());
+    ASSERT_EQ(serial_log, parallel_log);
+    ASSERT_EQ(serial.world->GetContent(), parallel.world->GetContent());
+    ASSERT_EQ(serial.comps_manager->complements.size(), parallel.comps_manager->complements.size());
+}
+
+// Benchmarks, skipped by default. Run them with --gtest_also_run_disabled_tests --gtest_filter=*Throughput*
+
+// Milliseconds one update of every complement takes on the board, each complement stepping once
+template<typename Status>
+double TimeFullBoardUpdates(CrowdedBoard<Status>& board, int complement_rows)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick <= complement_rows; tick++)
+    {
+        board.comps_manager->UpdateComplementsLifetime(0.6f);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+TEST(TestComplementsManager, DISABLED_MultiPlayerThroughput)
+{
+    constexpr int players_count = 1000;
+    constexpr int complement_rows = 100;
+
+    // Classes instantiation
+    CrowdedBoard<GameStatus> board(players_count, 1, complement_rows, [](int) { return std::make_unique<GameStatus>(); });
+    const size_t complements_count = board.comps_manager->complements.size();
+
+    // Invoke the method being tested
+    const double elapsed = TimeFullBoardUpdates(board, complement_rows);
+
+    std::cout << std::format("    {} players x {} complements: {:.2f} ms\n", players_count, complements_count, elapsed);
+
+    // Assertion
+    ASSERT_LT(board.comps_manager->complements.size(), size_t(players_count));
+}
+
+TEST(TestComplementsManager, DISABLED_ParallelThroughput)
+{
+    constexpr int players_count = 1000;
+    constexpr int complement_rows = 100;
+
+    // Powers of two up to the hardware thread count, which is always timed last
+    const int max_workers = std::max(int(std::thread::hardware_concurrency()), 1);
+    std::vector<int> worker_counts;
+    for (int workers = 1; workers < max_workers; workers *= 2)
+        worker_counts.push_back(workers);
+    worker_counts.push_back(max_workers);
+
+    double serial_elapsed = 0.0;
+
+    for (int workers : worker_counts)
+    {
+        // Classes instantiation
+        CrowdedBoard<GameStatus> board(players_count, 1, complement_rows, [](int) { return std::make_unique<GameStatus>(); });
+        board.comps_manager->SetWorkerCount(workers);
+
+        // Invoke the method being tested
+        const double elapsed = TimeFullBoardUpdates(board, complement_rows);
+        if (workers == 1)
+            serial_elapsed = elapsed;
+
+        std::cout << std::format("    {} workers: {:.2f} ms, {:.2f}x over 1 worker\n", workers, elapsed, serial_elapsed / elapsed);
+
+        // Assertion
+        ASSERT_LT(board.comps_manager->complements.size(), size_t(players_count));
+    }
+}
+
 // Run the tests
 int main(int argc, char** argv) {
     testing::InitGoogleMock(&argc, argv);